@@ -0,0 +1,604 @@
+#include <JuceHeader.h>
+#include <iostream>
+#include <thread>
+#include "../Source/SaunaControls.h"
+#include "../Source/Spatializer.h"
+#include "../Source/SteamAllocator.h"
+#include "../Source/Viewport.h"
+#include "OffscreenContext.h"
+#include "ReferenceBloom.h"
+
+const int BENCHMARK_FRAMES = 60; // Per configuration, unless overridden with --frames
+const std::array<juce::Point<int>, 3> BENCHMARK_SIZES{ { { 640, 360 }, { 1280, 720 }, { 1920, 1080 } } };
+const std::array<float, 3> BENCHMARK_SCALES{ 1.0f, 1.5f, 2.0f };
+const Vec3 BENCHMARK_SOURCE_POSITION{ 0.5f, 0.5f, 0.25f };
+
+// Billboard sweep, at one size and scale so only the marker count changes
+const std::array<int, 3> BENCHMARK_MARKER_COUNTS{ 256, 4096, 65536 };
+const juce::Point<int> BENCHMARK_MARKER_VIEWPORT{ 1280, 720 };
+const float BENCHMARK_MARKER_SCALE = 1.0f;
+const float BENCHMARK_MARKER_SIZE = 0.01f;
+const float BENCHMARK_MARKER_RADIUS = 2.0f; // Of the ball they fill, around the listener
+// Perlin texture, rendered at one size and scale with each way it can be uploaded
+const juce::Point<int> BENCHMARK_NOISE_VIEWPORT{ 1280, 720 };
+const float BENCHMARK_NOISE_SCALE = 1.0f;
+const int BENCHMARK_PROGRAM_LOADS = 5; // Of every program, from source with the binary cache cleared and then from the cache
+const int BENCHMARK_TOLERANCE = 2; // Per 8-bit channel, for rounding differences between drivers
+const double BENCHMARK_MAX_MISMATCH = 0.001; // Fraction of pixels allowed past the tolerance, against golden and reference images
+
+// Propagation delay, on a source orbiting the listener so the delay keeps gliding
+const std::array<int, 5> BENCHMARK_BLOCK_SIZES{ 64, 128, 256, 512, 1024 };
+const int BENCHMARK_SAMPLE_RATE = 48000;
+const double BENCHMARK_AUDIO_SECONDS = 20.0; // Of audio per block size, on and off each
+const float BENCHMARK_ORBIT_DISTANCE = 10.0f; // Metres, swinging by half as much either way
+const float BENCHMARK_ORBIT_HZ = 0.5f;
+
+const juce::Point<int> COMPONENT_SIZE{ 640, 360 }; // Never shown, every frame is rendered offscreen
+const std::chrono::seconds ASSETS_TIMEOUT{ 30 }; // For the worker to prepare the viewport's assets
+
+// Exit codes
+const int BENCHMARK_PASSED = 0;
+const int BENCHMARK_FAILED = 1; // An image differs from its golden image or its reference bloom, or has no golden image
+const int BENCHMARK_UNAVAILABLE = 2; // No GL context to render with
+
+// Only holds the parameters SaunaControls adds, nothing is ever processed
+struct ParameterHost: juce::AudioProcessor {
+    const juce::String getName() const override { return "Benchmark"; }
+    void prepareToPlay(double, int) override {}
+    void releaseResources() override {}
+    void processBlock(juce::AudioBuffer<float> &, juce::MidiBuffer &) override {}
+    double getTailLengthSeconds() const override { return 0.0; }
+    bool acceptsMidi() const override { return false; }
+    bool producesMidi() const override { return false; }
+    juce::AudioProcessorEditor *createEditor() override { return nullptr; }
+    bool hasEditor() const override { return false; }
+    int getNumPrograms() override { return 1; }
+    int getCurrentProgram() override { return 0; }
+    void setCurrentProgram(int) override {}
+    const juce::String getProgramName(int) override { return {}; }
+    void changeProgramName(int, juce::String const &) override {}
+    void getStateInformation(juce::MemoryBlock &) override {}
+    void setStateInformation(void const *, int) override {}
+};
+
+// How the icosphere's perlin texture reaches the GPU
+enum class NoiseUpload {
+    RGTC1, // The mip chain the asset worker encodes, as the viewport uploads it
+    R8 // The decoded image, with mip levels generated by the driver
+};
+
+// One measured configuration of the renderer. Its name is also the name of its golden image.
+struct RenderConfiguration {
+    juce::Point<int> size;
+    float rasterScale;
+    int markers{ 0 }; // Besides the listener
+    AntiAliasing antiAliasing{ AntiAliasing::Supersample }; // Multisampling ignores `rasterScale`
+    NoiseUpload noise{ NoiseUpload::RGTC1 };
+
+    juce::String name() const {
+        auto name = juce::String{ size.x } + "x" + juce::String{ size.y } + "@"
+            + (antiAliasing == AntiAliasing::Multisample ? juce::String{ "msaa" } : juce::String{ rasterScale, 2 });
+        if (markers > 0) name << "+" << markers << "markers";
+        if (noise == NoiseUpload::R8) name << "+r8";
+        return name;
+    }
+
+    // Spread evenly through a ball around the listener, in every hue
+    std::vector<ViewportFrame::Marker> markerField() const {
+        const float goldenAngle = juce::MathConstants<float>::pi * (3.0f - std::sqrt(5.0f));
+
+        std::vector<ViewportFrame::Marker> field;
+        field.reserve(static_cast<size_t>(markers));
+        for (int i{ 0 }; i < markers; i++) {
+            float fraction = (static_cast<float>(i) + 0.5f) / static_cast<float>(markers);
+            float z = 1.0f - 2.0f * fraction;
+            float ring = std::sqrt(1.0f - z * z);
+            float angle = goldenAngle * static_cast<float>(i);
+            float radius = BENCHMARK_MARKER_RADIUS * std::cbrt(fraction);
+            field.push_back({
+                .position = Vec3{ ring * std::cos(angle), ring * std::sin(angle), z } * radius,
+                .size = BENCHMARK_MARKER_SIZE,
+                .colour = juce::Colour::fromHSV(fraction, 0.75f, 1.0f, 1.0f)
+            });
+        }
+        return field;
+    }
+};
+
+// Pixels of one image that differ from another
+struct ImageDifference {
+    double mismatch; // Fraction past BENCHMARK_TOLERANCE
+    int maxDifference; // Largest in any 8-bit channel
+
+    bool matches() const {
+        return mismatch <= BENCHMARK_MAX_MISMATCH;
+    }
+
+    juce::String describe() const {
+        return juce::String(mismatch * 100.0, 3) + "% of pixels differ, by up to " + juce::String{ maxDifference } + "/255";
+    }
+};
+
+// Runs PropagationDelay over noise at each block size with the stage on, and bypassed so it only
+// records its input, then reports the time per block and its share of the block's real time.
+// Then counts what a Spatializer allocates through SteamAllocator.
+struct AudioBenchmark {
+    void run() const {
+        std::cout << "Audio benchmark, " << BENCHMARK_SAMPLE_RATE << " Hz stereo, "
+                  << juce::String(BENCHMARK_AUDIO_SECONDS, 1) << " s of audio per measurement" << std::endl;
+        for (int blockSize : BENCHMARK_BLOCK_SIZES) {
+            double on = measure(blockSize, true), off = measure(blockSize, false);
+            std::cout << "Propagation delay, " << blockSize << "-sample blocks: on " << describe(on, blockSize)
+                      << ", off " << describe(off, blockSize) << std::endl;
+        }
+        measureAllocations();
+    }
+
+private:
+    // Mean microseconds per block
+    static double measure(int blockSize, bool enabled) {
+        IPLAudioSettings settings{ .samplingRate = BENCHMARK_SAMPLE_RATE, .frameSize = blockSize };
+        PropagationDelay delay{ &settings, 2 };
+
+        juce::AudioBuffer<float> buffer{ 2, blockSize };
+        juce::Random random{ 1 };
+        int blocks = static_cast<int>(BENCHMARK_AUDIO_SECONDS * BENCHMARK_SAMPLE_RATE / blockSize);
+
+        double milliseconds{ 0.0 };
+        float sink{ 0.0f }; // Keeps the output observable
+        for (int block{ 0 }; block < blocks; block++) {
+            for (int channel{ 0 }; channel < 2; channel++) {
+                auto *samples = buffer.getWritePointer(channel);
+                for (int i{ 0 }; i < blockSize; i++) samples[i] = random.nextFloat() * 2.0f - 1.0f;
+            }
+
+            float time = static_cast<float>(block) * static_cast<float>(blockSize) / static_cast<float>(BENCHMARK_SAMPLE_RATE);
+            float phase = juce::MathConstants<float>::twoPi * BENCHMARK_ORBIT_HZ * time;
+            float distance = BENCHMARK_ORBIT_DISTANCE * (1.0f + 0.5f * std::sin(phase));
+
+            auto start = juce::Time::getMillisecondCounterHiRes();
+            delay.setParams(Vec3{ distance * std::cos(phase), distance * std::sin(phase), 0.0f }, enabled);
+            delay.processBlock(buffer, 2);
+            milliseconds += juce::Time::getMillisecondCounterHiRes() - start;
+            sink += buffer.getSample(0, blockSize - 1);
+        }
+        if (std::isnan(sink)) std::cout << "NaN in the output" << std::endl;
+        return milliseconds * 1.0e3 / blocks;
+    }
+
+    // Prepares a Spatializer at every block size on one context, like a host changing its block
+    // size, and processes a second of audio after each preparation
+    static void measureAllocations() {
+        SteamAllocator allocator;
+        IPLContextSettings contextSettings{
+            .version = STEAMAUDIO_VERSION,
+            .allocateCallback = allocator.getAllocateCallback(),
+            .freeCallback = allocator.getFreeCallback(),
+        };
+        IPLContext context{};
+        steam_assert(iplContextCreate(&contextSettings, &context), "Failed to initialize Steam Audio context");
+
+        {
+            std::optional<Spatializer> spatializer;
+            for (int blockSize : BENCHMARK_BLOCK_SIZES) {
+                IPLAudioSettings settings{ .samplingRate = BENCHMARK_SAMPLE_RATE, .frameSize = blockSize };
+                spatializer.reset(); // Back into the pool before the next one allocates
+                spatializer.emplace(context, &settings);
+
+                juce::AudioBuffer<float> buffer{ 2, blockSize };
+                buffer.clear();
+                SteamAllocator::RealtimeSection realtime{ allocator };
+                for (int block{ 0 }; block < BENCHMARK_SAMPLE_RATE / blockSize; block++) {
+                    spatializer->setParams(BENCHMARK_SOURCE_POSITION, 1.0f, true);
+                    spatializer->processBlock(buffer, 2);
+                }
+            }
+        }
+        auto live = allocator.getStats();
+        iplContextRelease(&context);
+        auto stats = allocator.getStats();
+
+        std::cout << "Steam Audio allocator: " << stats.allocations << " allocations, " << stats.systemAllocations
+                  << " of them from the system and " << stats.realtimeAllocations << " while processing, peak "
+                  << juce::String(static_cast<double>(stats.bytesPeak) / 1024.0, 1) << " KiB, "
+                  << juce::String(static_cast<double>(live.bytesLive) / 1024.0, 1) << " KiB held by the context alone, "
+                  << juce::String(static_cast<double>(stats.bytesPooled) / 1024.0, 1) << " KiB pooled once it's released";
+        if (allocator.getAllocateCallback() == nullptr) std::cout << " (no free slot, so nothing was counted)";
+        std::cout << std::endl;
+    }
+
+    static juce::String describe(double microseconds, int blockSize) {
+        double budget = 1.0e6 * blockSize / BENCHMARK_SAMPLE_RATE;
+        return juce::String(microseconds, 3) + " us (" + juce::String(100.0 * microseconds / budget, 3) + "% of real time)";
+    }
+};
+
+// Renders a fixed frame through the viewport's own `renderScene` in each configuration, then
+// reports CPU and GPU times per pass and compares the output with the golden images, and with
+// the same frame bloomed by ReferenceBloom.
+struct ViewportBenchmark {
+    juce::File goldenDirectory;
+    bool record{ false }; // Replaces the golden images instead of checking against them
+    int frames{ BENCHMARK_FRAMES };
+
+    // With a context current on this thread. Nullopt if the viewport's assets never arrived,
+    // otherwise whether every image matched its golden image.
+    std::optional<bool> run(ViewportComponent &viewport) const {
+        using namespace juce::gl;
+
+        viewport.allowFallback = false; // Software renderers are benchmarked like any other
+        viewport.initialise();
+
+        auto deadline = std::chrono::steady_clock::now() + ASSETS_TIMEOUT;
+        while (!viewport.tryUploadAssets()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                viewport.shutdown();
+                return std::nullopt;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{ 10 });
+        }
+
+        goldenDirectory.createDirectory();
+        std::cout << "Viewport benchmark on " << reinterpret_cast<char const *>(glGetString(GL_RENDERER))
+                  << ", OpenGL " << reinterpret_cast<char const *>(glGetString(GL_VERSION))
+                  << ", " << frames << " frames per configuration" << std::endl;
+
+        bool passed{ true };
+        for (auto size : BENCHMARK_SIZES) {
+            for (float scale : BENCHMARK_SCALES) {
+                passed = measure(viewport, { size, scale }) && passed;
+            }
+        }
+        for (auto size : BENCHMARK_SIZES) {
+            passed = measure(viewport, { .size = size, .rasterScale = 1.0f, .antiAliasing = AntiAliasing::Multisample }) && passed;
+        }
+        for (int markers : BENCHMARK_MARKER_COUNTS) {
+            passed = measure(viewport, { BENCHMARK_MARKER_VIEWPORT, BENCHMARK_MARKER_SCALE, markers }) && passed;
+        }
+        passed = measure(viewport, { .size = BENCHMARK_NOISE_VIEWPORT, .rasterScale = BENCHMARK_NOISE_SCALE, .noise = NoiseUpload::R8 }) && passed;
+        measureUploads();
+        measureProgramLoads();
+
+        viewport.shutdown();
+
+        std::cout << (passed ? "Output matches " : "Output differs from ") << (record ? "the reference bloom" : "the golden images and the reference bloom") << std::endl;
+        return passed;
+    }
+
+private:
+    // Prints one line of timings for `configuration`, and returns whether its image matched
+    bool measure(ViewportComponent &viewport, RenderConfiguration const &configuration) const {
+        using namespace juce::gl;
+
+        auto size = configuration.size;
+        PostProcess target{
+            viewport.downsampleShader,
+            viewport.msaaResolveShader,
+            viewport.cinematicShader,
+            viewport.bloomDownsampleShader,
+            viewport.bloomBlurShader,
+            viewport.bloomUpsampleShader,
+            size,
+            RASTER_SUPERSAMPLE
+        };
+        auto name = configuration.name();
+        if (configuration.antiAliasing == AntiAliasing::Multisample) {
+            target.sizeTo(size, RASTER_SUPERSAMPLE, AntiAliasing::Multisample);
+            if (target.antiAliasing != AntiAliasing::Multisample) {
+                std::cout << name << ": skipped, the driver can't multisample" << std::endl;
+                return true;
+            }
+        }
+        target.setRasterScale(configuration.rasterScale);
+        GLBackBuffer output{ size, false, GL_RGBA8 };
+
+        // Swapped in for this configuration only, the viewport keeps its own texture
+        auto const *uploadedNoise = viewport.icosphere->texture0;
+        std::optional<GLImageTexture> noise;
+        if (configuration.noise == NoiseUpload::R8) {
+            noise.emplace(loadPerlin(), GL_R8);
+            viewport.icosphere->texture0 = &*noise;
+        }
+
+        ViewportFrame frame{
+            .projection = ViewportComponent::projectionFor(size),
+            .view = ViewportComponent::viewFor(ViewportComponent::INITIAL_MOUSE),
+            .icosphereModel = rotationTranslationScale(Vec3{}, BENCHMARK_SOURCE_POSITION, ICOSPHERE_SCALE),
+            .size = size,
+            .secondsElapsed = 0.0f,
+            .trail = false,
+            .markers = configuration.markerField()
+        };
+
+        // Untimed, since drivers compile shader variants and commit memory on the first draw
+        viewport.glState.beginFrame();
+        viewport.renderScene(frame, target, output.frameBuffer, nullptr);
+        glFinish();
+
+        std::optional<GLPassProfiler> passProfiler;
+        if (GLTimerQuery::isSupported()) passProfiler.emplace();
+
+        double cpuMilliseconds{ 0.0 };
+        std::vector<std::pair<juce::String, double>> passMilliseconds; // Summed over the timed frames
+        int timed{ 0 };
+        size_t intermediateBytes{ 0 };
+        for (int i{ 0 }; i < frames; i++) {
+            // Constructing targets binds behind the cache's back, so every frame starts from scratch
+            viewport.glState.beginFrame();
+
+            auto start = juce::Time::getMillisecondCounterHiRes();
+            viewport.renderScene(frame, target, output.frameBuffer, passProfiler ? &*passProfiler : nullptr);
+            cpuMilliseconds += juce::Time::getMillisecondCounterHiRes() - start;
+            intermediateBytes = viewport.glState.getCounters().intermediateBytes;
+
+            // Waiting keeps frames from overlapping, so every query has finished when collected
+            glFinish();
+            if (passProfiler && passProfiler->collect()) {
+                auto passes = passProfiler->breakdown();
+                if (passMilliseconds.empty()) passMilliseconds.assign(passes.size(), { {}, 0.0 });
+                for (size_t pass{ 0 }; pass < passes.size() && pass < passMilliseconds.size(); pass++) {
+                    passMilliseconds[pass].first = passes[pass].first;
+                    passMilliseconds[pass].second += passes[pass].second;
+                }
+                timed++;
+            }
+        }
+        viewport.icosphere->texture0 = uploadedNoise;
+
+        juce::String report;
+        report << name;
+        if (target.multisampleBuffer) report << " (" << target.multisampleBuffer->samples << " samples)";
+        report << ": CPU " << juce::String(cpuMilliseconds / frames, 3) << " ms";
+        if (timed > 0) {
+            double gpuMilliseconds{ 0.0 };
+            for (auto const &pass : passMilliseconds) gpuMilliseconds += pass.second;
+            report << ", GPU " << juce::String(gpuMilliseconds / timed, 3) << " ms (";
+            for (size_t pass{ 0 }; pass < passMilliseconds.size(); pass++) {
+                report << (pass > 0 ? ", " : "") << passMilliseconds[pass].first << " " << juce::String(passMilliseconds[pass].second / timed, 3) << " ms";
+            }
+            report << ")";
+        }
+        report << ", " << juce::String(static_cast<double>(intermediateBytes) / (1024.0 * 1024.0), 2) << " MiB offscreen";
+
+        auto image = readPixels(output, size);
+        bool matches = checkGolden(name, image, report);
+        matches = checkReference(viewport, target, image, bloomMilliseconds(passMilliseconds, timed), report) && matches;
+        std::cout << report << std::endl;
+        return matches;
+    }
+
+    // Prints one line per way of uploading the perlin texture, with the time to submit the upload,
+    // the time until the GPU has finished it and, where timer queries are supported, its GPU time
+    void measureUploads() const {
+        auto image = loadPerlin();
+
+        auto encodeStart = juce::Time::getMillisecondCounterHiRes();
+        auto chain = CompressedMipChain::fromImage(image);
+        double encodeMilliseconds = juce::Time::getMillisecondCounterHiRes() - encodeStart;
+
+        size_t chainBytes{ 0 };
+        for (auto const &level : chain.levels) chainBytes += level.blocks.size();
+
+        size_t imageBytes{ 0 };
+        for (int width{ image.getWidth() }, height{ image.getHeight() }; ; width = std::max(width / 2, 1), height = std::max(height / 2, 1)) {
+            imageBytes += static_cast<size_t>(width) * static_cast<size_t>(height);
+            if (width == 1 && height == 1) break;
+        }
+
+        measureUpload("Perlin R8 upload", imageBytes, [&](std::optional<GLImageTexture> &texture) {
+            texture.emplace(image, juce::gl::GL_R8);
+        });
+        measureUpload("Perlin RGTC1 upload", chainBytes, [&](std::optional<GLImageTexture> &texture) {
+            texture.emplace(chain);
+        }, " after encoding for " + juce::String(encodeMilliseconds, 3) + " ms on the asset worker");
+    }
+
+    template <typename Upload>
+    void measureUpload(juce::String const &name, size_t bytes, Upload &&upload, juce::String const &preparation = {}) const {
+        using namespace juce::gl;
+
+        std::optional<GLTimerQuery> timer;
+        if (GLTimerQuery::isSupported()) timer.emplace();
+
+        double cpuMilliseconds{ 0.0 }, finishedMilliseconds{ 0.0 }, gpuMilliseconds{ 0.0 };
+        int timed{ 0 };
+        for (int i{ -1 }; i < frames; i++) { // Once untimed, for the same reason as the warm-up frame
+            std::optional<GLImageTexture> texture;
+
+            auto start = juce::Time::getMillisecondCounterHiRes();
+            if (timer) timer->begin();
+            upload(texture);
+            if (timer) timer->end();
+            auto submitted = juce::Time::getMillisecondCounterHiRes();
+            glFinish();
+            auto finished = juce::Time::getMillisecondCounterHiRes();
+
+            auto gpu = timer ? timer->collect() : std::nullopt;
+            if (i < 0) continue;
+            cpuMilliseconds += submitted - start;
+            finishedMilliseconds += finished - start;
+            if (gpu) {
+                gpuMilliseconds += *gpu;
+                timed++;
+            }
+        }
+
+        juce::String report;
+        report << name << ": CPU " << juce::String(cpuMilliseconds / frames, 3) << " ms, finished after " << juce::String(finishedMilliseconds / frames, 3) << " ms";
+        if (timed > 0) report << ", GPU " << juce::String(gpuMilliseconds / timed, 3) << " ms";
+        report << ", " << juce::String(static_cast<double>(bytes) / 1024.0, 1) << " KiB with mip levels" << preparation;
+        std::cout << report << std::endl;
+    }
+
+    static juce::Image loadPerlin() {
+        return juce::ImageFileFormat::loadFrom(BinaryData::perlin_jpg, BinaryData::perlin_jpgSize);
+    }
+
+    // Prints the time to load every program the viewport uses, compiled and linked from source with
+    // the program binary cache cleared, then read back from the binaries that load saved
+    void measureProgramLoads() const {
+        auto cache = pluginDataDirectory().getChildFile("ProgramCache");
+
+        double coldMilliseconds{ 0.0 }, warmMilliseconds{ 0.0 };
+        for (int i{ 0 }; i < BENCHMARK_PROGRAM_LOADS; i++) {
+            cache.deleteRecursively();
+            coldMilliseconds += timeProgramLoad();
+            warmMilliseconds += timeProgramLoad();
+        }
+
+        std::cout << "Program loads: cold " << juce::String(coldMilliseconds / BENCHMARK_PROGRAM_LOADS, 3)
+                  << " ms, warm " << juce::String(warmMilliseconds / BENCHMARK_PROGRAM_LOADS, 3)
+                  << " ms from " << cache.getFullPathName() << std::endl;
+    }
+
+    // Until the programs are usable from any context, like GLShareGroup waits for
+    static double timeProgramLoad() {
+        auto start = juce::Time::getMillisecondCounterHiRes();
+        ViewportSharedResources resources;
+        resources.loadPrograms();
+        juce::gl::glFinish();
+        return juce::Time::getMillisecondCounterHiRes() - start;
+    }
+
+    // Over the bloom passes, averaged like the rest of the breakdown
+    static std::optional<double> bloomMilliseconds(std::vector<std::pair<juce::String, double>> const &passMilliseconds, int timed) {
+        if (timed == 0) return std::nullopt;
+
+        double sum{ 0.0 };
+        for (auto const &pass : passMilliseconds) {
+            if (pass.first.startsWith("Bloom")) sum += pass.second;
+        }
+        return sum / timed;
+    }
+
+    // Blooms the scene `target` last rendered the old way, and compares the two images
+    bool checkReference(ViewportComponent &viewport, PostProcess const &target, juce::Image const &image, std::optional<double> bloomMilliseconds, juce::String &report) const {
+        using namespace juce::gl;
+
+        ReferenceBloom reference{ target.viewportSize };
+
+        // Once untimed, for the same reason as the viewport's warm-up frame
+        std::optional<double> referenceMilliseconds;
+        for (int i{ 0 }; i < 2; i++) {
+            viewport.glState.beginFrame();
+            reference.render(viewport.glState, target);
+            glFinish();
+            referenceMilliseconds = reference.bloomMilliseconds();
+        }
+
+        if (bloomMilliseconds && referenceMilliseconds) {
+            report << ", bloom " << juce::String(*bloomMilliseconds, 3) << " ms against " << juce::String(*referenceMilliseconds, 3) << " ms for the reference";
+        }
+
+        auto referenceImage = readPixels(reference.output, target.viewportSize);
+        auto difference = compare(image, referenceImage);
+        report << ", " << difference.describe() << " from the reference" << (difference.matches() ? "" : " FAILED");
+        return difference.matches();
+    }
+
+    // A missing golden image fails, so a run can't pass by recording its own output
+    bool checkGolden(juce::String const &name, juce::Image const &image, juce::String &report) const {
+        auto goldenFile = goldenDirectory.getChildFile(name + ".png");
+        if (record) {
+            goldenFile.deleteFile();
+            juce::FileOutputStream stream{ goldenFile };
+            bool written = stream.openedOk() && juce::PNGImageFormat{}.writeImageToStream(image, stream);
+            report << (written ? ", recorded golden image" : ", couldn't record golden image FAILED");
+            return written;
+        }
+
+        auto golden = juce::ImageFileFormat::loadFrom(goldenFile);
+        if (!golden.isValid()) {
+            report << ", no golden image FAILED";
+            return false;
+        }
+
+        auto difference = compare(image, golden);
+        report << ", " << difference.describe() << " from the golden image" << (difference.matches() ? "" : " FAILED");
+        return difference.matches();
+    }
+
+    // Reads back the bottom-left `size` pixels of `buffer`, flipped into image rows
+    static juce::Image readPixels(GLBackBuffer const &buffer, juce::Point<int> size) {
+        using namespace juce::gl;
+
+        std::vector<juce::uint8> pixels(static_cast<size_t>(size.x) * static_cast<size_t>(size.y) * 4);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, buffer.frameBuffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        OPENGL_ASSERT();
+
+        juce::Image image{ juce::Image::RGB, size.x, size.y, false };
+        juce::Image::BitmapData bitmap{ image, juce::Image::BitmapData::writeOnly };
+        for (int y{ 0 }; y < size.y; y++) {
+            auto const *row = pixels.data() + static_cast<size_t>(size.y - 1 - y) * static_cast<size_t>(size.x) * 4;
+            for (int x{ 0 }; x < size.x; x++) {
+                bitmap.setPixelColour(x, y, juce::Colour{ row[x * 4], row[x * 4 + 1], row[x * 4 + 2] });
+            }
+        }
+        return image;
+    }
+
+    static ImageDifference compare(juce::Image const &image, juce::Image const &expected) {
+        if (image.getBounds() != expected.getBounds()) return { 1.0, 255 };
+
+        juce::Image::BitmapData pixels{ image, juce::Image::BitmapData::readOnly };
+        juce::Image::BitmapData expectedPixels{ expected, juce::Image::BitmapData::readOnly };
+
+        size_t mismatched{ 0 };
+        int maxDifference{ 0 };
+        for (int y{ 0 }; y < image.getHeight(); y++) {
+            for (int x{ 0 }; x < image.getWidth(); x++) {
+                auto a = pixels.getPixelColour(x, y), b = expectedPixels.getPixelColour(x, y);
+                int difference = std::max({
+                    std::abs(a.getRed() - b.getRed()),
+                    std::abs(a.getGreen() - b.getGreen()),
+                    std::abs(a.getBlue() - b.getBlue())
+                });
+                if (difference > BENCHMARK_TOLERANCE) mismatched++;
+                maxDifference = std::max(maxDifference, difference);
+            }
+        }
+        return { static_cast<double>(mismatched) / (static_cast<double>(image.getWidth()) * image.getHeight()), maxDifference };
+    }
+};
+
+// Usage: SaunaBenchmark [--golden <folder>] [--record] [--frames <count>], from the repository root
+// by default. Renders without a window or display, so it runs as is on a headless machine.
+int main(int argc, char *argv[]) {
+    juce::ScopedJuceInitialiser_GUI juceInitialiser; // The viewport is a component, even though it's never shown
+
+    juce::StringArray arguments;
+    for (int i{ 1 }; i < argc; i++) arguments.add(argv[i]);
+
+    ViewportBenchmark benchmark;
+    benchmark.record = arguments.contains("--record");
+    benchmark.goldenDirectory = juce::File::getCurrentWorkingDirectory().getChildFile("Benchmark/golden");
+    if (int index = arguments.indexOf("--golden"); index >= 0 && index + 1 < arguments.size()) {
+        benchmark.goldenDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(arguments[index + 1].unquoted());
+    }
+    if (int index = arguments.indexOf("--frames"); index >= 0 && index + 1 < arguments.size()) {
+        benchmark.frames = std::max(arguments[index + 1].getIntValue(), 1);
+    }
+
+    AudioBenchmark{}.run();
+
+    OffscreenContext context;
+    if (!context.isCurrent()) {
+        std::cerr << "No offscreen OpenGL context to benchmark with" << std::endl;
+        return BENCHMARK_UNAVAILABLE;
+    }
+
+    ParameterHost host;
+    SaunaControls controls{ host };
+    ViewportComponent viewport{ controls };
+    viewport.setSize(COMPONENT_SIZE.x, COMPONENT_SIZE.y);
+
+    auto passed = benchmark.run(viewport);
+    if (!passed) {
+        std::cerr << "The viewport's assets were never uploaded" << std::endl;
+        return BENCHMARK_UNAVAILABLE;
+    }
+    return *passed ? BENCHMARK_PASSED : BENCHMARK_FAILED;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_LINUX
+ #define EGL_NO_X11 1
+ #include <EGL/egl.h>
+ #include <EGL/eglext.h>
+#endif
+
+// A GL 3.2 core context without any window or surface, current on the thread that created it,
+// so frames only ever go to framebuffer objects. Mesa's surfaceless platform needs no display
+// server at all; other EGL drivers fall back to their default display.
+struct OffscreenContext {
+    OffscreenContext(OffscreenContext const &) = delete;
+    OffscreenContext &operator=(OffscreenContext const &) = delete;
+
+    OffscreenContext() {
+#if JUCE_LINUX
+        auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        juce::String extensions{ eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS) };
+        if (getPlatformDisplay && extensions.contains("EGL_MESA_platform_surfaceless")) {
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        } else {
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+            display = EGL_NO_DISPLAY;
+            return;
+        }
+
+        if (!juce::String{ eglQueryString(display, EGL_EXTENSIONS) }.contains("EGL_KHR_surfaceless_context")) return;
+        if (!eglBindAPI(EGL_OPENGL_API)) return;
+
+        EGLint const attributes[]{
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 2,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+        if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) return;
+
+        // JUCE resolves its GL entry points through the current context
+        juce::gl::loadFunctions();
+        current = true;
+#endif
+    }
+
+    ~OffscreenContext() {
+#if JUCE_LINUX
+        if (display == EGL_NO_DISPLAY) return;
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+        eglTerminate(display);
+#endif
+    }
+
+    // False without EGL, or when the driver can't make a core context without a surface
+    bool isCurrent() const {
+        return current;
+    }
+
+private:
+    bool current{ false };
+#if JUCE_LINUX
+    EGLDisplay display{ EGL_NO_DISPLAY };
+    EGLContext context{ EGL_NO_CONTEXT };
+#endif
+};
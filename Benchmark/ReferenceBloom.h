@@ -0,0 +1,149 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "../Source/Viewport.h"
+
+// The bloom from before the mip chain, kept to check the viewport's bloom against. Every level
+// gets a separable Gaussian at its own resolution and is added straight into a full-resolution
+// copy of the scene, then box-filtered down to start the next level.
+// Two things differ from the loop as it shipped, neither of them part of the look. Its buffers are
+// half floats, where the packed floats lost up to 11/255 to rounding over the seven passes. Its
+// shaders clamp inside each level, where they used to filter in the unused part of the buffer.
+struct ReferenceBloom {
+    static constexpr int DOWNSAMPLE = 2; // Between levels
+
+    GLMesh fullscreenQuad;
+
+    std::shared_ptr<GLProgram>
+        gaussianShader,
+        accumulateShader;
+
+    GLProgram::Uniform
+        gaussianSourceResolutionUniform,
+        gaussianVerticalUniform,
+        accumulateStrengthUniform,
+        accumulateDownsampleRatioUniform;
+
+    GLPassUniforms passUniforms; // For the viewport's own passes
+
+    // All at the full size, later levels use their bottom-left corner
+    GLBackBuffer
+        compositingBuffer,
+        bufferA,
+        bufferB,
+        output;
+
+    std::optional<GLTimerQuery> timer; // Absent without timer query support
+
+    ReferenceBloom(ReferenceBloom const &) = delete;
+    ReferenceBloom &operator=(ReferenceBloom const &) = delete;
+
+    explicit ReferenceBloom(juce::Point<int> size) :
+        fullscreenQuad{ GLMesh::screenQuad() },
+        gaussianShader{ loadShader(BinaryData::gaussian_frag_glsl, "gaussianShader") },
+        accumulateShader{ loadShader(BinaryData::bloomAccumulate_frag_glsl, "bloomAccumulateShader") },
+
+        gaussianSourceResolutionUniform{ *gaussianShader, "sourceResolution" },
+        gaussianVerticalUniform        { *gaussianShader, "vertical" },
+
+        accumulateStrengthUniform       { *accumulateShader, "strength" },
+        accumulateDownsampleRatioUniform{ *accumulateShader, "downsampleRatio" },
+
+        compositingBuffer{ size, false, juce::gl::GL_RGBA16F },
+        bufferA{ size, false, juce::gl::GL_RGBA16F },
+        bufferB{ size, false, juce::gl::GL_RGBA16F },
+        output{ size, false, juce::gl::GL_RGBA8 }
+    {
+        bindSamplers(*gaussianShader, { "sourceTexture" });
+        bindSamplers(*accumulateShader, { "sourceTexture" });
+        if (accumulateStrengthUniform.uniformID >= 0) { accumulateStrengthUniform.set(BLOOM_STRENGTH); }
+
+        if (GLTimerQuery::isSupported()) timer.emplace();
+    }
+
+    // Blooms the scene `target` last processed and composites it through the same cinematic
+    // pass into `output`, so the two only differ in their bloom
+    void render(GLStateCache &state, PostProcess const &target) {
+        using namespace juce::gl;
+
+        state.setDepth(false, false);
+        state.setAdditiveBlend(false);
+
+        // Copies the resolved scene, wherever `target` keeps it
+        auto const &scene = target.fuseResolve ? *target.rasterBuffer : *target.compositingBuffer;
+        compositingBuffer.setRenderTarget();
+        state.useProgram(*target.downsampleShader);
+        passUniforms.update({ .supersample = { 1.0f, 1.0f } });
+        scene.bindTexture(state, 0);
+        state.drawElements(fullscreenQuad);
+
+        if (timer) timer->begin();
+        compositingBuffer.blitInto(bufferA.frameBuffer, compositingBuffer.resolution);
+
+        GLBackBuffer const *vertical{ &bufferA }, *horizontal{ &bufferB };
+        juce::Point<int> bounds{ vertical->resolution };
+        for (int pass{ 0 }; ; ++pass) {
+            // 1. Gaussian blur X from vertical to horizontal
+            state.useProgram(*gaussianShader);
+            if (gaussianSourceResolutionUniform.uniformID >= 0) { gaussianSourceResolutionUniform.set(bounds.toFloat().x, bounds.toFloat().y); }
+            if (gaussianVerticalUniform.uniformID >= 0) { gaussianVerticalUniform.set(0); } // Horizontally
+
+            horizontal->setRenderTarget(true, bounds);
+            vertical->bindTexture(state, 0);
+            state.drawElements(fullscreenQuad);
+
+            // 2. Gaussian blur Y from horizontal to vertical
+            if (gaussianVerticalUniform.uniformID >= 0) { gaussianVerticalUniform.set(1); } // Vertically
+            vertical->setRenderTarget(false, bounds); // Can skip clearing because downscale cleared it
+            horizontal->bindTexture(state, 0);
+            state.drawElements(fullscreenQuad);
+
+            // 3. Additive blend vertical to compositing buffer
+            state.setAdditiveBlend(true);
+
+            // Downsample relative to vertical resolution because UV coordinates scale with texture bounds
+            auto ratio = vertical->resolution.toFloat() / bounds.toFloat();
+            compositingBuffer.setRenderTarget();
+            state.useProgram(*accumulateShader);
+            if (accumulateDownsampleRatioUniform.uniformID >= 0) { accumulateDownsampleRatioUniform.set(ratio.x, ratio.y); }
+            vertical->bindTexture(state, 0);
+            state.drawElements(fullscreenQuad);
+
+            state.setAdditiveBlend(false);
+
+            if (pass == BLOOM_PASSES - 1) break;
+
+            // 4. Downsample vertical to horizontal
+            bounds /= DOWNSAMPLE;
+            horizontal->setRenderTarget(true, bounds);
+            state.useProgram(*target.downsampleShader);
+            passUniforms.update({ .supersample = { static_cast<float>(DOWNSAMPLE), static_cast<float>(DOWNSAMPLE) } });
+            vertical->bindTexture(state, 0);
+            state.drawElements(fullscreenQuad);
+
+            // 5. Swap buffers
+            std::swap(horizontal, vertical);
+        }
+        if (timer) timer->end();
+
+        // Cinematic, with the bloom already in the scene
+        output.setRenderTarget();
+        state.useProgram(*target.cinematicShader);
+        passUniforms.update({ .bloomStrength = 0.0f });
+        compositingBuffer.bindTexture(state, 0);
+        compositingBuffer.bindTexture(state, 1);
+        state.drawElements(fullscreenQuad);
+    }
+
+    // GPU time of the last `render`'s bloom, once the GPU has finished it
+    std::optional<double> bloomMilliseconds() {
+        return timer ? timer->collect() : std::nullopt;
+    }
+
+private:
+    static std::shared_ptr<GLProgram> loadShader(char const *fragmentSource, char const *name) {
+        std::shared_ptr<GLProgram> shader;
+        tryLoadShader(shader, BinaryData::postprocess_vert_glsl, fragmentSource, name);
+        return shader;
+    }
+};
@@ -0,0 +1,16 @@
+#version 150
+
+in vec2 vTexCoord;
+
+uniform sampler2D sourceTexture;
+uniform vec2 downsampleRatio;
+uniform float strength;
+
+out vec4 fragColor;
+
+void main() {
+    // Clamped inside the level, past it filtering would blend in the unused part of the buffer
+    vec2 edge = 0.5 / vec2(textureSize(sourceTexture, 0));
+    vec2 uv = clamp(vTexCoord / downsampleRatio, edge, 1.0 / downsampleRatio - edge);
+    fragColor = texture(sourceTexture, uv, 0) * vec4(vec3(strength), 1.0);
+}
\ No newline at end of file
@@ -39,9 +39,10 @@ vec4 blur(vec2 blurDirection) {
 
     vec2 fullResolution = vec2(textureSize(sourceTexture, 0));
     vec2 scale = sourceResolution / fullResolution;
+    vec2 edge = 0.5 / sourceResolution; // Past it, filtering would blend in the unused part of the buffer
     for (int i = 0; i < SAMPLE_COUNT; ++i) {
         vec2 offset = blurDirection * OFFSETS[i] / sourceResolution;
-        sum += texture(sourceTexture, clamp(vTexCoord + offset, 0, 1) * scale) * WEIGHTS[i];
+        sum += texture(sourceTexture, clamp(vTexCoord + offset, edge, 1.0 - edge) * scale) * WEIGHTS[i];
     }
 
     return sum;
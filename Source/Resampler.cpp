@@ -0,0 +1,145 @@
+#include "Resampler.h"
+#include "simd.h"
+
+#include <numbers>
+
+using std::numbers::pi;
+
+constexpr int TAPS_PER_PHASE = 48;
+constexpr double CUTOFF = 0.46; // Fraction of the internal rate, 22kHz at 48kHz
+
+// Blackman-windowed sinc with unity DC gain, `cutoff` in cycles per sample
+static std::vector<double> designLowpass(int length, double cutoff) {
+    std::vector<double> kernel(static_cast<size_t>(length));
+    double center = (length - 1) / 2.0, sum{ 0.0 };
+
+    for (int i{ 0 }; i < length; i++) {
+        double x = i - center;
+        double sinc = x == 0.0 ? 2.0 * cutoff : std::sin(2.0 * pi * cutoff * x) / (pi * x);
+        double window = 0.42
+            - 0.5 * std::cos(2.0 * pi * i / (length - 1))
+            + 0.08 * std::cos(4.0 * pi * i / (length - 1));
+
+        kernel[i] = sinc * window;
+        sum += kernel[i];
+    }
+
+    for (auto &tap : kernel) tap /= sum;
+    return kernel;
+}
+
+int ResamplingBridge::factorFor(double sampleRate) {
+    int factor{ 1 };
+    while (factor < MAX_RATE_REDUCTION && sampleRate / (factor * 2) >= MIN_INTERNAL_RATE) {
+        factor *= 2;
+    }
+    return factor;
+}
+
+// Each filter delays by (taps - 1) / 2, and aligning decimation with the queue adds one sample
+int ResamplingBridge::latencyFor(int factor) {
+    return factor > 1 ? TAPS_PER_PHASE * factor - 1 : 0;
+}
+
+ResamplingBridge::ResamplingBridge(int factor, int numInputChannels, int numOutputChannels, int maxBlockSize) :
+    factor{ factor },
+    taps{ TAPS_PER_PHASE * factor - 1 }, // Odd length keeps the group delay a whole sample
+    phaseTaps{ TAPS_PER_PHASE },
+    queued{ factor }
+{
+    jassert(factor > 1);
+
+    auto kernel = designLowpass(taps, CUTOFF / factor);
+
+    decimationKernel.resize(static_cast<size_t>(taps));
+    for (int i{ 0 }; i < taps; i++) {
+        decimationKernel[i] = static_cast<float>(kernel[taps - 1 - i]);
+    }
+
+    // Zero-stuffing divides the signal by `factor`, so each phase makes it back up
+    kernel.resize(static_cast<size_t>(phaseTaps * factor), 0.0);
+    interpolationKernels.resize(static_cast<size_t>(factor));
+    for (int p{ 0 }; p < factor; p++) {
+        auto &phaseKernel = interpolationKernels[p];
+        phaseKernel.resize(static_cast<size_t>(phaseTaps));
+        for (int i{ 0 }; i < phaseTaps; i++) {
+            phaseKernel[i] = static_cast<float>(kernel[(phaseTaps - 1 - i) * factor + p] * factor);
+        }
+    }
+
+    int maxReducedBlock = (maxBlockSize + factor - 1) / factor;
+
+    inputHistory.setSize(numInputChannels, taps - 1 + maxBlockSize);
+    reduced.setSize(std::max(numInputChannels, numOutputChannels), phaseTaps - 1 + maxReducedBlock);
+    outputQueue.setSize(numOutputChannels, maxBlockSize + 2 * factor);
+    inputHistory.clear();
+    reduced.clear();
+    outputQueue.clear(); // The first `factor` queued samples are silence
+}
+
+juce::AudioBuffer<float> &ResamplingBridge::decimate(juce::AudioBuffer<float> const &buffer, int numInputChannels) {
+    int numSamples = buffer.getNumSamples();
+    int history = taps - 1, reducedHistory = phaseTaps - 1;
+    int produced{ 0 };
+
+    numInputChannels = std::min(numInputChannels, inputHistory.getNumChannels());
+    jassert(numSamples <= inputHistory.getNumSamples() - history);
+
+    for (int channel{ 0 }; channel < numInputChannels; channel++) {
+        float *line = inputHistory.getWritePointer(channel);
+        float *output = reduced.getWritePointer(channel, reducedHistory);
+        juce::FloatVectorOperations::copy(line + history, buffer.getReadPointer(channel), numSamples);
+
+        // Only evaluate the filter at the samples that survive decimation
+        produced = 0;
+        for (int i{ factor - 1 - phase }; i < numSamples; i += factor) {
+            output[produced++] = simd::dotProduct(decimationKernel.data(), line + i, taps);
+        }
+
+        std::memmove(line, line + numSamples, static_cast<size_t>(history) * sizeof(float));
+    }
+
+    phase = (phase + numSamples) % factor;
+
+    reducedView.setDataToReferTo(
+        reduced.getArrayOfWritePointers(),
+        reduced.getNumChannels(),
+        reducedHistory,
+        produced
+    );
+    return reducedView;
+}
+
+void ResamplingBridge::interpolate(juce::AudioBuffer<float> &buffer) {
+    int numSamples = buffer.getNumSamples();
+    int produced = reducedView.getNumSamples();
+    int history = phaseTaps - 1;
+    int numChannels = std::min(buffer.getNumChannels(), outputQueue.getNumChannels());
+
+    jassert(queued + produced * factor <= outputQueue.getNumSamples());
+
+    for (int channel{ 0 }; channel < numChannels; channel++) {
+        float *line = reduced.getWritePointer(channel);
+        float *queue = outputQueue.getWritePointer(channel, queued);
+
+        // Each reduced sample expands into one output per phase
+        for (int j{ 0 }; j < produced; j++) {
+            for (int p{ 0 }; p < factor; p++) {
+                *queue++ = simd::dotProduct(interpolationKernels[p].data(), line + j, phaseTaps);
+            }
+        }
+
+        std::memmove(line, line + produced, static_cast<size_t>(history) * sizeof(float));
+    }
+    queued += produced * factor;
+
+    // The queue was primed with `factor` samples, so it always covers the host block
+    jassert(queued >= numSamples);
+    int remaining = queued - numSamples;
+    for (int channel{ 0 }; channel < numChannels; channel++) {
+        float *queue = outputQueue.getWritePointer(channel);
+        juce::FloatVectorOperations::copy(buffer.getWritePointer(channel), queue, numSamples);
+        std::memmove(queue, queue + numSamples, static_cast<size_t>(remaining) * sizeof(float));
+    }
+    queued = remaining;
+}
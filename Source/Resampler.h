@@ -0,0 +1,47 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+// Lowest rate the spatializer is allowed to run at when reducing the internal rate
+constexpr double MIN_INTERNAL_RATE = 44100.0;
+constexpr int MAX_RATE_REDUCTION = 4;
+
+// Polyphase FIR decimator and interpolator pair, so a block processor can run
+// at an integer fraction of the host rate. Both filters are linear phase, and
+// the round trip delays the signal by exactly `getLatency()` host samples.
+struct ResamplingBridge {
+    // Largest power-of-two reduction that keeps the internal rate at or above MIN_INTERNAL_RATE
+    static int factorFor(double sampleRate);
+    static int latencyFor(int factor);
+
+    ResamplingBridge(int factor, int numInputChannels, int numOutputChannels, int maxBlockSize);
+    ResamplingBridge(ResamplingBridge const &) = delete;
+    ResamplingBridge &operator=(ResamplingBridge const &) = delete;
+    ~ResamplingBridge() = default;
+
+    int getFactor() const { return factor; }
+    int getLatency() const { return latencyFor(factor); }
+
+    // Filters and decimates the input channels of `buffer`. The returned view
+    // holds the reduced-rate block, which may be empty for very short host blocks.
+    juce::AudioBuffer<float> &decimate(juce::AudioBuffer<float> const &buffer, int numInputChannels);
+
+    // Interpolates the output channels of the view returned by `decimate` back into `buffer`
+    void interpolate(juce::AudioBuffer<float> &buffer);
+
+private:
+    int factor;
+    int taps, phaseTaps;
+    int phase{ 0 };
+
+    // Kernels are stored reversed so each output is a forward dot product
+    std::vector<float> decimationKernel;
+    std::vector<std::vector<float>> interpolationKernels; // One per output phase
+
+    juce::AudioBuffer<float> inputHistory; // taps - 1 samples of history, then the host block
+    juce::AudioBuffer<float> reduced; // phaseTaps - 1 samples of history, then the reduced block
+    juce::AudioBuffer<float> reducedView; // Non-owning view of the current reduced block
+    juce::AudioBuffer<float> outputQueue; // Interpolated samples waiting to be returned to the host
+    int queued;
+};
@@ -22,6 +22,12 @@ SaunaControls::SaunaControls(juce::AudioProcessor &processor) :
 	mode{ new juce::AudioParameterChoice("mode", "Mode", { "Static", "Orbit", "Path" }, 0) },
 	minDistance{ new juce::AudioParameterFloat("minDistance", "Min. Distance", 0.1f, 10.0f, 0.2f) },
 	tempoSync{ new juce::AudioParameterBool("tempoSync", "Tempo sync", true) },
+	propagationDelay{ new juce::AudioParameterBool("propagationDelay", "Doppler", false) },
+	// Changes latency, so the processor rebuilds its bridge with processing suspended
+	reducedRate{ new juce::AudioParameterBool(
+		"reducedRate", "Reduced internal rate", false,
+		juce::AudioParameterBoolAttributes{}.withAutomatable(false)
+	) },
 
 	staticPosition{ vectorParam([](int i, char axis) {
 		return new juce::AudioParameterFloat(
@@ -53,6 +59,8 @@ SaunaControls::SaunaControls(juce::AudioProcessor &processor) :
 	processor.addParameter(phase);
 	processor.addParameter(tempoSync);
 	processor.addParameter(minDistance);
+	processor.addParameter(propagationDelay);
+	processor.addParameter(reducedRate);
 	processor.addParameter(mode);
 	for (auto * ptr : staticPosition) processor.addParameter(ptr);
 	for (auto * ptr : orbitCenter   ) processor.addParameter(ptr);
@@ -62,7 +70,19 @@ SaunaControls::SaunaControls(juce::AudioProcessor &processor) :
 	processor.addParameter(orbitRotation);
 }
 
-Vec3 SaunaControls::updatePosition(float time) {
+Vec3 SaunaControls::updatePosition(double time, bool playing, double audibleAt) {
+	Vec3 value = evaluate(time);
+
+	lastSample.store({ .position = value, .time = time, .audibleAt = audibleAt, .playing = playing });
+	return value;
+}
+
+bool SaunaControls::isDeterministic() const {
+	auto index = static_cast<SaunaMode>(mode->getIndex());
+	return index == SaunaMode::Static || index == SaunaMode::Orbit;
+}
+
+Vec3 SaunaControls::evaluate(double time) const {
 	auto index = mode->getIndex();
 	Vec3 value;
 
@@ -83,14 +103,14 @@ Vec3 SaunaControls::updatePosition(float time) {
 		throw std::runtime_error{ std::format("Undefined mode {}", index) };
 	}
 
-	lastPosition.store(value);
 	return value;
 }
 
-Vec3 SaunaControls::orbit(float time) const {
-	float theta = (time + phase->get()) * speed->get();
+Vec3 SaunaControls::orbit(double time) const {
+	// Wrap before narrowing, otherwise hours into a session the angle has no fractional precision left
+	double theta = std::fmod((time + phase->get()) * speed->get(), 2.0 * pi);
 
-	Vec3 point = Vec3::rotation2D(theta) * orbitRadius->get();
+	Vec3 point = Vec3::rotation2D(static_cast<float>(theta)) * orbitRadius->get();
 	point.x *= orbitStretch->get();
 	point = point.rotateZ(orbitRotation->get());
 
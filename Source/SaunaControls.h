@@ -11,6 +11,14 @@ struct PathNode {
 	float nextDuration;
 };
 
+// A published source position, stamped with when it is expected to be heard
+struct PositionSample {
+	Vec3 position{};
+	double time{ 0.0 }; // Playhead seconds the position was evaluated at
+	double audibleAt{ 0.0 }; // On `monotonicSeconds`, shared by the audio and GL threads
+	bool playing{ false }; // Whether `time` advances with the clock
+};
+
 const int SAUNA_MODE_SIZE = 3;
 enum struct SaunaMode: int {
 	Static,
@@ -24,8 +32,16 @@ struct SaunaControls {
 	SaunaControls(SaunaControls const &) = delete;
 	~SaunaControls() = default;
 
-	Vec3 updatePosition(float time);
-	Vec3 getLastPosition() const { return lastPosition.load(); }
+	Vec3 updatePosition(double time, bool playing, double audibleAt);
+	Vec3 getLastPosition() const { return lastSample.load().position; }
+	double getLastTime() const { return lastSample.load().time; }
+	PositionSample getLastSample() const { return lastSample.load(); }
+
+	// Static and Orbit positions are a function of time, so they can be evaluated for any moment
+	bool isDeterministic() const;
+
+	// Position at `time` under the current parameters, without publishing it
+	Vec3 evaluate(double time) const;
 
 	// Global params
 	juce::AudioParameterChoice *mode;
@@ -33,6 +49,8 @@ struct SaunaControls {
 	juce::AudioParameterFloat *phase;
 	juce::AudioParameterBool *tempoSync;
 	juce::AudioParameterFloat *minDistance;
+	juce::AudioParameterBool *propagationDelay;
+	juce::AudioParameterBool *reducedRate;
 
 	// Static params
 	std::array<juce::AudioParameterFloat *, 3> staticPosition;
@@ -50,6 +68,6 @@ struct SaunaControls {
 	unsigned int currentNode{};
 
 private:
-	std::atomic<Vec3> lastPosition{}; // std::atomic falls back to Mutex for large types
-	Vec3 orbit(float time) const;
+	SeqLock<PositionSample> lastSample{}; // Written by the audio thread, read by the GL and message threads
+	Vec3 orbit(double time) const;
 };
\ No newline at end of file
@@ -208,19 +208,51 @@ void ControlPanelComponent::paint(juce::Graphics &graphics) {
 }
 
 
+AllocatorStatsComponent::AllocatorStatsComponent(SaunaProcessor &processor) : processor{ processor } {
+    startTimerHz(4);
+}
+
+void AllocatorStatsComponent::timerCallback() {
+    stats = processor.getAllocatorStats();
+    repaint();
+}
+
+void AllocatorStatsComponent::paint(juce::Graphics &graphics) {
+    graphics.fillAll(juce::Colour::fromHSL(0.0f, 0.0f, 0.15f, 1.0));
+
+    juce::StringArray lines{
+        "Steam Audio memory",
+        "Live: " + juce::File::descriptionOfSizeInBytes(static_cast<juce::int64>(stats.bytesLive)),
+        "Peak: " + juce::File::descriptionOfSizeInBytes(static_cast<juce::int64>(stats.bytesPeak)),
+        "Pooled: " + juce::File::descriptionOfSizeInBytes(static_cast<juce::int64>(stats.bytesPooled)),
+        juce::String(stats.allocations) + " allocs, " + juce::String(stats.systemAllocations) + " from system",
+        juce::String(stats.realtimeAllocations) + " on audio thread",
+    };
+
+    graphics.setColour(stats.realtimeAllocations > 0 ? ACCENT_COLOR : juce::Colours::lightgrey);
+    graphics.setFont(12.0f);
+    auto bounds = getLocalBounds().reduced(8);
+    for (auto &line : lines) {
+        graphics.drawText(line, bounds.removeFromTop(16), juce::Justification::centredLeft);
+    }
+}
+
+
 SaunaEditor::SaunaEditor(SaunaProcessor &processor) :
     AudioProcessorEditor{ &processor },
     audioProcessor{ processor },
 	controlPanel{ processor.getControls() },
     constrainer{},
     resizer{ this, &constrainer },
-	viewportFrame{ processor.getControls() }
+	viewportFrame{ processor.getControls() },
+    allocatorStats{ processor }
 {
     setSize(640, 480);
     setTitle("Sauna");
 
     addAndMakeVisible(viewportFrame);
     addAndMakeVisible(controlPanel);
+    addAndMakeVisible(allocatorStats);
     resizer.setAlwaysOnTop(true);
     addAndMakeVisible(resizer);
     constrainer.setMinimumSize(300, 250);
@@ -234,6 +266,8 @@ void SaunaEditor::resized() {
 	resizer.setBounds(getWidth() - 16, getHeight() - 16, 16, 16);
 
 	auto bounds = getLocalBounds();
-	controlPanel.setBounds(bounds.removeFromBottom(120));
+	auto panelBounds = bounds.removeFromBottom(120);
+	allocatorStats.setBounds(panelBounds.removeFromRight(180));
+	controlPanel.setBounds(panelBounds);
 	viewportFrame.setBounds(bounds);
 }
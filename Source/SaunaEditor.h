@@ -3,25 +3,59 @@
 #include <JuceHeader.h>
 #include "SaunaProcessor.h"
 #include "Viewport.h"
+#include "TopDownView.h"
 
 const juce::Colour ACCENT_COLOR = juce::Colour::fromHSL(0.11f, 1.0f, 0.35f, 1.0);
 
 struct ViewportFrameComponent: juce::Component {
     juce::Path roundRectPath;
     juce::DropShadow dropShadow;
-    ViewportComponent viewport;
+    SaunaControls const &pluginState;
+
+    // One or the other. The 2D view replaces the 3D one on request, or when GL is too slow for it.
+    // Each editor starts in 3D and measures again, since the GPU or its load may have changed.
+    std::optional<ViewportComponent> viewport;
+    std::optional<TopDownViewComponent> topDown;
 
     ViewportFrameComponent(SaunaControls const &pluginState) :
         dropShadow{ juce::Colour::fromFloatRGBA(0.0f, 0.0f, 0.0f, 0.6f), 4, { 0, 2 } },
-        viewport{ pluginState }
+        pluginState{ pluginState }
     {
-        addAndMakeVisible(viewport);
+        showViewport(true);
         roundRectPath.addRoundedRectangle(0.0f, 0.0f, static_cast<float>(getWidth()), static_cast<float>(getHeight()) , 3.0f);
     }
 
+    // Switching destroys the view that asked for it, so it waits until the request has returned
+    void showViewport(bool allowFallback) {
+        topDown.reset();
+        viewport.emplace(pluginState);
+        viewport->allowFallback = allowFallback;
+        viewport->onTopDownRequested = [this](bool) {
+            juce::MessageManager::callAsync([safe = SafePointer<ViewportFrameComponent>{ this }]() {
+                if (safe) safe->showTopDown();
+            });
+        };
+        addAndMakeVisible(*viewport);
+        resized();
+    }
+
+    void showTopDown() {
+        viewport.reset();
+        topDown.emplace(pluginState);
+        topDown->onViewportRequested = [this]() {
+            // Chosen by hand, so it stays in 3D however slow it is
+            juce::MessageManager::callAsync([safe = SafePointer<ViewportFrameComponent>{ this }]() {
+                if (safe) safe->showViewport(false);
+            });
+        };
+        addAndMakeVisible(*topDown);
+        resized();
+    }
+
 	void resized() override {
         auto bounds = getLocalBounds().reduced(16);
-		viewport.setBounds(bounds);
+        if (viewport) viewport->setBounds(bounds);
+        if (topDown) topDown->setBounds(bounds);
 
 		roundRectPath.clear();
 		roundRectPath.addRoundedRectangle(
@@ -137,6 +171,22 @@ struct ControlPanelComponent: juce::Component {
     void resized() override;
 };
 
+// Shows what Steam Audio has allocated, refreshed a few times a second
+struct AllocatorStatsComponent: juce::Component, private juce::Timer {
+    SaunaProcessor &processor;
+    SteamAllocatorStats stats{};
+
+    AllocatorStatsComponent(SaunaProcessor &processor);
+    AllocatorStatsComponent(AllocatorStatsComponent const &) = delete;
+    AllocatorStatsComponent &operator=(AllocatorStatsComponent const &) = delete;
+    ~AllocatorStatsComponent() override = default;
+
+    void paint(juce::Graphics &) override;
+
+private:
+    void timerCallback() override;
+};
+
 struct SaunaEditor: juce::AudioProcessorEditor {
     SaunaEditor(SaunaProcessor&);
     SaunaEditor(const SaunaEditor&) = delete;
@@ -152,6 +202,7 @@ private:
     juce::ResizableCornerComponent resizer;
 	ViewportFrameComponent viewportFrame;
 	ControlPanelComponent controlPanel;
+    AllocatorStatsComponent allocatorStats;
 
     JUCE_LEAK_DETECTOR(SaunaEditor)
 };
@@ -1,5 +1,6 @@
 #include "SaunaProcessor.h"
 #include "SaunaEditor.h"
+#include "simd.h"
 #include <format>
 
 static juce::AudioProcessorValueTreeState::ParameterLayout buildLayout() {
@@ -24,6 +25,8 @@ SaunaProcessor::SaunaProcessor() :
 {
     IPLContextSettings contextSettings{
         .version = STEAMAUDIO_VERSION,
+        .allocateCallback = allocator.getAllocateCallback(),
+        .freeCallback = allocator.getFreeCallback(),
     };
 
     steam_assert(
@@ -31,10 +34,16 @@ SaunaProcessor::SaunaProcessor() :
         "Failed to initialize Steam Audio context"
     );
 
+    controls.reducedRate->addListener(this);
+
     juce::Logger::outputDebugString("Test");
 }
 
 SaunaProcessor::~SaunaProcessor() {
+    controls.reducedRate->removeListener(this);
+    cancelPendingUpdate();
+    bridge.reset();
+    bed.reset();
     spatializer.reset();
     iplContextRelease(&steam_audio_context);
 }
@@ -61,46 +70,140 @@ void SaunaProcessor::changeProgramName(int, juce::String const &) {}
 
 
 void SaunaProcessor::prepareToPlay(double sampleRate, int samplesPerBlock) {
+    // Everything Steam Audio needs is built here, and reuses blocks pooled by earlier preparations
+    int factor = controls.reducedRate->get() ? ResamplingBridge::factorFor(sampleRate) : 1;
+
     IPLAudioSettings audioSettings{
-        .samplingRate = static_cast<int>(sampleRate),
-        .frameSize = samplesPerBlock,
+        .samplingRate = static_cast<int>(sampleRate) / factor,
+        .frameSize = (samplesPerBlock + factor - 1) / factor,
     };
     spatializer.emplace(steam_audio_context, &audioSettings);
+
+    auto inputLayout = getChannelLayoutOfBus(true, 0);
+    if (VirtualSpeakerBed::supports(inputLayout)) {
+        bed.emplace(steam_audio_context, &audioSettings, spatializer->getHrtf(), inputLayout);
+    } else {
+        bed.reset();
+    }
+
+    if (factor > 1) {
+        bridge.emplace(factor, getTotalNumInputChannels(), 2, samplesPerBlock);
+    } else {
+        bridge.reset();
+    }
+    setLatencySamples(ResamplingBridge::latencyFor(factor));
+
+    precisionScratch.setSize(std::max(getTotalNumInputChannels(), getTotalNumOutputChannels()), samplesPerBlock);
 }
 
 void SaunaProcessor::releaseResources() {
+    precisionScratch.setSize(0, 0);
+    bridge.reset();
+    bed.reset();
     spatializer.reset();
 }
 
+// May arrive on any thread, including the audio thread, so the rebuild waits for the message thread
+void SaunaProcessor::parameterValueChanged(int, float) {
+    triggerAsyncUpdate();
+}
+
+// The bridge and the latency it adds only change in prepareToPlay, so the audio thread never waits
+// on a rebuild. Until the host re-prepares, the current rate keeps playing.
+void SaunaProcessor::handleAsyncUpdate() {
+    if (!spatializer || getSampleRate() <= 0.0) return; // Picked up by the next prepareToPlay
+
+    int factor = controls.reducedRate->get() ? ResamplingBridge::factorFor(getSampleRate()) : 1;
+    if (factor == (bridge ? bridge->getFactor() : 1)) return;
+
+    // Hosts re-prepare on a latency change, which is when the new rate takes over
+    updateHostDisplay(juce::AudioProcessorListener::ChangeDetails{}.withLatencyChanged(true));
+}
+
 bool SaunaProcessor::isBusesLayoutSupported(BusesLayout const &layouts) const {
     // Output must be stereo
     if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo()) return false;
 
-    // Input may be mono or stereo
+    // Input may be mono, stereo, or a surround bed
     auto inputs = layouts.getMainInputChannelSet();
-    if (inputs != juce::AudioChannelSet::stereo() && inputs != juce::AudioChannelSet::mono()) return false;
-    
+    if (
+        inputs != juce::AudioChannelSet::stereo()
+        && inputs != juce::AudioChannelSet::mono()
+        && !VirtualSpeakerBed::supports(inputs)
+    ) return false;
+
     return true;
 }
 
 void SaunaProcessor::processBlock(juce::AudioBuffer<float> &buffer, juce::MidiBuffer &) {
     juce::ScopedNoDenormals noDenormals;
+    SteamAllocator::RealtimeSection realtime{ allocator }; // Counts any allocation Steam Audio makes on the audio thread
 
     try {
         auto playheadPosition = playHead.load()->getPosition();
         double time = playheadPosition.hasValue() ? playheadPosition->getTimeInSeconds().orFallback(0.0) : 0.0;
-
-        auto position = controls.updatePosition(static_cast<float>(time));
-
-        spatializer.value()
-            .setParams(position, controls.minDistance->get())
-            .processBlock(buffer, getMainBusNumInputChannels());
+        bool playing = playheadPosition.hasValue() && playheadPosition->getIsPlaying();
+
+        // The block starts playing once the host has played out the one before it, plus our own latency
+        double audibleAt = monotonicSeconds() + (buffer.getNumSamples() + getLatencySamples()) / getSampleRate();
+
+        auto position = controls.updatePosition(time, playing, audibleAt);
+        int inputChannels = getMainBusNumInputChannels();
+
+        // Beds are turned as a unit by the trajectory, rather than placed at it
+        if (bed) {
+            bed->setParams(position - LISTENER_POSITION, Vec3{ controls.orbitAxis });
+        } else {
+            spatializer.value().setParams(position, controls.minDistance->get(), controls.propagationDelay->get());
+        }
+
+        auto render{ [this, inputChannels](juce::AudioBuffer<float> &block) {
+            if (bed) {
+                bed->processBlock(block);
+            } else {
+                spatializer.value().processBlock(block, inputChannels);
+            }
+        } };
+
+        if (bridge) {
+            auto &reduced = bridge->decimate(buffer, inputChannels);
+            if (reduced.getNumSamples() > 0) {
+                render(reduced);
+            }
+            bridge->interpolate(buffer);
+        } else {
+            render(buffer);
+        }
     } catch (std::exception e) {
         DBG(e.what());
     }
 }
 
 
+// Steam Audio only works in float, so convert through preallocated scratch, one prepared block at a time
+void SaunaProcessor::processBlock(juce::AudioBuffer<double> &buffer, juce::MidiBuffer &midi) {
+    int numChannels = std::min(buffer.getNumChannels(), precisionScratch.getNumChannels());
+    int chunkSize = precisionScratch.getNumSamples();
+    jassert(numChannels == buffer.getNumChannels());
+    if (chunkSize == 0) return;
+
+    for (int start{ 0 }; start < buffer.getNumSamples(); start += chunkSize) {
+        int length = std::min(chunkSize, buffer.getNumSamples() - start);
+        juce::AudioBuffer<float> chunk{ precisionScratch.getArrayOfWritePointers(), numChannels, length };
+
+        for (int channel{ 0 }; channel < numChannels; channel++) {
+            simd::convert(chunk.getWritePointer(channel), buffer.getReadPointer(channel, start), length);
+        }
+
+        processBlock(chunk, midi);
+
+        for (int channel{ 0 }; channel < numChannels; channel++) {
+            simd::convert(buffer.getWritePointer(channel, start), chunk.getReadPointer(channel), length);
+        }
+    }
+}
+
+
 bool SaunaProcessor::hasEditor() const { return true; }
 
 juce::AudioProcessorEditor* SaunaProcessor::createEditor() {
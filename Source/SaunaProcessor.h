@@ -2,9 +2,11 @@
 
 #include <JuceHeader.h>
 #include "Spatializer.h"
+#include "Resampler.h"
 #include "SaunaControls.h"
+#include "SteamAllocator.h"
 
-struct SaunaProcessor: juce::AudioProcessor {
+struct SaunaProcessor: juce::AudioProcessor, private juce::AudioProcessorParameter::Listener, private juce::AsyncUpdater {
     SaunaProcessor();
     ~SaunaProcessor() override;
     SaunaProcessor(SaunaProcessor const &) = delete;
@@ -15,6 +17,8 @@ struct SaunaProcessor: juce::AudioProcessor {
     bool isBusesLayoutSupported(BusesLayout const&layouts) const override;
 
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     juce::AudioProcessorEditor *createEditor() override;
     bool hasEditor() const override;
@@ -35,11 +39,22 @@ struct SaunaProcessor: juce::AudioProcessor {
     void setStateInformation(const void *data, int sizeInBytes) override;
 
 	SaunaControls &getControls() { return controls; }
+    SteamAllocatorStats getAllocatorStats() const { return allocator.getStats(); }
 
 private:
+    SteamAllocator allocator; // Declared first so it outlives everything Steam Audio allocates
     IPLContext steam_audio_context{};
     std::optional<Spatializer> spatializer{};
+    std::optional<VirtualSpeakerBed> bed{}; // Present for surround inputs
+    std::optional<ResamplingBridge> bridge{}; // Present when running below the host rate
+    juce::AudioBuffer<float> precisionScratch{}; // Float copy of double-precision host blocks
     SaunaControls controls;
 
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int, bool) override {}
+
+    // Asks the host to re-prepare for a changed internal rate, which rebuilds the bridge
+    void handleAsyncUpdate() override;
+
     JUCE_LEAK_DETECTOR(SaunaProcessor)
 };
@@ -109,11 +109,295 @@ void DirectEffect::processBlock(IPLAudioBuffer buffer) {
 }
 
 
+// Implementation for PropagationDelay
+PropagationDelay::PropagationDelay(IPLAudioSettings *audioSettings, int numChannels) :
+    sampleRate{ static_cast<float>(audioSettings->samplingRate) },
+    maxDelay{ MAX_PROPAGATION_DELAY * static_cast<float>(audioSettings->samplingRate) }
+{
+    // Room for the longest delay, one block of new input, and the interpolator's lookahead
+    int lineSize = juce::nextPowerOfTwo(static_cast<int>(std::ceil(maxDelay)) + audioSettings->frameSize + 4);
+    mask = lineSize - 1;
+    line.setSize(numChannels, lineSize);
+    line.clear();
+
+    auto frameSize = static_cast<size_t>(audioSettings->frameSize);
+    taps.resize(frameSize);
+    for (auto &buffer : coefficients) buffer.resize(frameSize);
+    for (auto &buffer : gathered) buffer.resize(frameSize);
+
+    setParams(DEFAULT_SOURCE_POSITION, false);
+}
+
+void PropagationDelay::setParams(Vec3 position, bool enable) {
+    float distance = (position - LISTENER_POSITION).magnitude();
+
+    // Third-order Lagrange reads one sample ahead of the tap, so 2 samples is the shortest delay
+    targetDelay = std::clamp(distance / SPEED_OF_SOUND * sampleRate, 2.0f, maxDelay);
+
+    // Snap instead of gliding while bypassed, so enabling fades in at the current distance
+    // rather than sweeping the pitch from a stale one
+    if (!enabled) currentDelay = targetDelay;
+    enabled = enable;
+}
+
+void PropagationDelay::processBlock(juce::AudioBuffer<float> &buffer, int numChannels) {
+    using Vector = juce::FloatVectorOperations;
+
+    int numSamples = buffer.getNumSamples();
+    numChannels = std::min(numChannels, line.getNumChannels());
+    jassert(numSamples <= static_cast<int>(taps.size()));
+
+    // Always record input, so enabling the stage doesn't replay stale audio
+    int blockStart = writeIndex;
+    int firstPart = std::min(numSamples, line.getNumSamples() - blockStart);
+    for (int channel{ 0 }; channel < numChannels; channel++) {
+        Vector::copy(line.getWritePointer(channel, blockStart), buffer.getReadPointer(channel), firstPart);
+        Vector::copy(line.getWritePointer(channel), buffer.getReadPointer(channel, firstPart), numSamples - firstPart);
+    }
+    writeIndex = (blockStart + numSamples) & mask;
+
+    if (numSamples == 0) return;
+    bool fadeIn = enabled && !delayed, fadeOut = !enabled && delayed;
+    delayed = enabled;
+    if (!enabled && !fadeOut) return;
+
+    // Read positions and Lagrange weights depend only on the delay ramp, so compute them once
+    double start = currentDelay, step = (targetDelay - currentDelay) / static_cast<double>(numSamples);
+    for (int i{ 0 }; i < numSamples; i++) {
+        double position = static_cast<double>(i) - (start + step * static_cast<double>(i + 1));
+        double whole = std::floor(position);
+        float d = static_cast<float>(position - whole);
+
+        // First of the four taps at offsets -1, 0, 1, 2 around the read position
+        taps[i] = blockStart + static_cast<int>(whole) - 1;
+
+        float dm1 = d - 1.0f, dm2 = d - 2.0f, dp1 = d + 1.0f;
+        coefficients[0][i] = -d * dm1 * dm2 / 6.0f;
+        coefficients[1][i] = dp1 * dm1 * dm2 / 2.0f;
+        coefficients[2][i] = -dp1 * d * dm2 / 2.0f;
+        coefficients[3][i] = dp1 * d * dm1 / 6.0f;
+    }
+    currentDelay = targetDelay;
+
+    // Gather into contiguous rows, then sum the weighted rows with vectorised kernels
+    for (int channel{ 0 }; channel < numChannels; channel++) {
+        float const *source = line.getReadPointer(channel);
+
+        for (size_t tap{ 0 }; tap < 4; tap++) {
+            float *row = gathered[tap].data();
+            int offset = static_cast<int>(tap);
+            for (int i{ 0 }; i < numSamples; i++) {
+                row[i] = source[(taps[i] + offset) & mask];
+            }
+        }
+
+        float *output = buffer.getWritePointer(channel);
+        Vector::multiply(output, coefficients[0].data(), gathered[0].data(), numSamples);
+        Vector::addWithMultiply(output, coefficients[1].data(), gathered[1].data(), numSamples);
+        Vector::addWithMultiply(output, coefficients[2].data(), gathered[2].data(), numSamples);
+        Vector::addWithMultiply(output, coefficients[3].data(), gathered[3].data(), numSamples);
+
+        // From the dry input, still in the line, so toggling the stage doesn't click
+        if (fadeIn || fadeOut) {
+            for (int i{ 0 }; i < numSamples; i++) {
+                float gain = static_cast<float>(i + 1) / static_cast<float>(numSamples);
+                if (fadeOut) gain = 1.0f - gain;
+                float dry = source[(blockStart + i) & mask];
+                output[i] = dry + gain * (output[i] - dry);
+            }
+        }
+    }
+}
+
+
+// Implementation for VirtualSpeakerBed
+std::optional<Vec3> VirtualSpeakerBed::speakerDirection(juce::AudioChannelSet::ChannelType channel) {
+    using Channel = juce::AudioChannelSet::ChannelType;
+
+    // Azimuths in degrees clockwise from straight ahead, following ITU-R BS.775 and BS.2051
+    float azimuth;
+    switch (channel) {
+    case Channel::centre:            azimuth =    0.0f; break;
+    case Channel::left:              azimuth =  -30.0f; break;
+    case Channel::right:             azimuth =   30.0f; break;
+    case Channel::leftCentre:        azimuth =  -15.0f; break;
+    case Channel::rightCentre:       azimuth =   15.0f; break;
+    case Channel::wideLeft:          azimuth =  -60.0f; break;
+    case Channel::wideRight:         azimuth =   60.0f; break;
+    case Channel::leftSurroundSide:  azimuth =  -90.0f; break;
+    case Channel::rightSurroundSide: azimuth =   90.0f; break;
+    case Channel::leftSurround:      azimuth = -110.0f; break;
+    case Channel::rightSurround:     azimuth =  110.0f; break;
+    case Channel::leftSurroundRear:  azimuth = -150.0f; break;
+    case Channel::rightSurroundRear: azimuth =  150.0f; break;
+    case Channel::centreSurround:    azimuth =  180.0f; break;
+    default: return std::nullopt;
+    }
+
+    float radians = juce::degreesToRadians(azimuth);
+    return Vec3{ std::sin(radians), std::cos(radians), 0.0f };
+}
+
+bool VirtualSpeakerBed::supports(juce::AudioChannelSet const &layout) {
+    if (layout.size() <= 2 || layout.isDiscreteLayout()) return false;
+
+    for (auto channel : layout.getChannelTypes()) {
+        bool isLfe = channel == juce::AudioChannelSet::LFE || channel == juce::AudioChannelSet::LFE2;
+        if (!isLfe && !speakerDirection(channel)) return false;
+    }
+    return true;
+}
+
+VirtualSpeakerBed::VirtualSpeakerBed(
+    IPLContext context,
+    IPLAudioSettings *audioSettings,
+    IPLHRTF sharedHrtf,
+    juce::AudioChannelSet const &layout
+) :
+    context{ context },
+    hrtf{ iplHRTFRetain(sharedHrtf) } // Share the spatializer's HRTF rather than loading another
+{
+    IPLAmbisonicsEncodeEffectSettings encodeSettings{
+        .maxOrder = BED_AMBISONICS_ORDER
+    };
+
+    auto channels = layout.getChannelTypes();
+    for (int i{ 0 }; i < channels.size(); i++) {
+        auto direction = speakerDirection(channels[i]);
+
+        if (!direction) {
+            lfeChannels.push_back(i);
+            continue;
+        }
+
+        auto &speaker = speakers.emplace_back(Speaker{ .channel = i, .direction = *direction, .effect = {} });
+        steam_assert(
+            iplAmbisonicsEncodeEffectCreate(context, audioSettings, &encodeSettings, &speaker.effect),
+            "Failed to create Ambisonics Encode Effect"
+        );
+    }
+
+    IPLAmbisonicsDecodeEffectSettings decodeSettings{
+        .speakerLayout = { .type = IPL_SPEAKERLAYOUTTYPE_STEREO },
+        .hrtf = hrtf,
+        .maxOrder = BED_AMBISONICS_ORDER
+    };
+    steam_assert(
+        iplAmbisonicsDecodeEffectCreate(context, audioSettings, &decodeSettings, &decoder),
+        "Failed to create Ambisonics Decode Effect"
+    );
+
+    int ambisonicChannels = (BED_AMBISONICS_ORDER + 1) * (BED_AMBISONICS_ORDER + 1);
+    steam_assert(
+        iplAudioBufferAllocate(context, ambisonicChannels, audioSettings->frameSize, &encoded),
+        "Failed to allocate ambisonic encoding buffer"
+    );
+    steam_assert(
+        iplAudioBufferAllocate(context, ambisonicChannels, audioSettings->frameSize, &soundField),
+        "Failed to allocate ambisonic sound field buffer"
+    );
+    steam_assert(
+        iplAudioBufferAllocate(context, 2, audioSettings->frameSize, &output),
+        "Failed to allocate output buffer"
+    );
+}
+
+VirtualSpeakerBed::~VirtualSpeakerBed() {
+    iplAudioBufferFree(context, &output);
+    iplAudioBufferFree(context, &soundField);
+    iplAudioBufferFree(context, &encoded);
+    iplAmbisonicsDecodeEffectRelease(&decoder);
+    for (auto &speaker : speakers) {
+        iplAmbisonicsEncodeEffectRelease(&speaker.effect);
+    }
+    iplHRTFRelease(&hrtf);
+}
+
+VirtualSpeakerBed &VirtualSpeakerBed::setParams(Vec3 newFront, Vec3 newUp) {
+    up = newUp.isOrigin() ? Vec3::up() : newUp.normalized();
+
+    // Flatten the front onto the plane the layout turns in
+    Vec3 flat = newFront - up * newFront.dot(up);
+    if (flat.magnitude() < 1e-4f) {
+        flat = Vec3::forward() - up * Vec3::forward().dot(up);
+    }
+    if (flat.magnitude() < 1e-4f) {
+        flat = Vec3{ 0.0f, 0.0f, -1.0f }; // `up` is forward, so any perpendicular will do
+    }
+
+    front = flat.normalized();
+    right = front.cross(up);
+    return *this;
+}
+
+VirtualSpeakerBed &VirtualSpeakerBed::processBlock(juce::AudioBuffer<float> &buffer) {
+    int numSamples = buffer.getNumSamples();
+
+    auto view{ [numSamples](IPLAudioBuffer source) {
+        source.numSamples = numSamples;
+        return source;
+    } };
+    IPLAudioBuffer encodedView = view(encoded), soundFieldView = view(soundField), outputView = view(output);
+
+    for (int i{ 0 }; i < soundField.numChannels; i++) {
+        juce::FloatVectorOperations::clear(soundField.data[i], numSamples);
+    }
+
+    // Encode every speaker into one sound field, rotated with the layout
+    for (auto &speaker : speakers) {
+        // cast because Steam Audio is not const-correct
+        float *channel = const_cast<float *>(buffer.getReadPointer(speaker.channel));
+        IPLAudioBuffer input{
+            .numChannels = 1,
+            .numSamples = numSamples,
+            .data = &channel
+        };
+
+        Vec3 direction = right * speaker.direction.x + front * speaker.direction.y + up * speaker.direction.z;
+        IPLAmbisonicsEncodeEffectParams encodeParams{
+            .direction = direction.toSteam(),
+            .order = BED_AMBISONICS_ORDER
+        };
+
+        iplAmbisonicsEncodeEffectApply(speaker.effect, &encodeParams, &input, &encodedView);
+        iplAudioBufferMix(context, &encodedView, &soundFieldView);
+    }
+
+    // Single binaural decode for the whole bed
+    IPLAmbisonicsDecodeEffectParams decodeParams{
+        .order = BED_AMBISONICS_ORDER,
+        .hrtf = hrtf,
+        .orientation = {
+            .right = Vec3{ 1.0f, 0.0f, 0.0f }.toSteam(),
+            .up = Vec3::up().toSteam(),
+            .ahead = Vec3::forward().toSteam(),
+            .origin = LISTENER_POSITION.toSteam()
+        },
+        .binaural = IPL_TRUE
+    };
+    iplAmbisonicsDecodeEffectApply(decoder, &decodeParams, &soundFieldView, &outputView);
+
+    // LFE has no direction, so it goes to both ears unprocessed
+    for (int channel : lfeChannels) {
+        float const *lfe = buffer.getReadPointer(channel);
+        juce::FloatVectorOperations::addWithMultiply(output.data[0], lfe, BED_LFE_GAIN, numSamples);
+        juce::FloatVectorOperations::addWithMultiply(output.data[1], lfe, BED_LFE_GAIN, numSamples);
+    }
+
+    size_t buffer_size = numSamples * sizeof(float);
+    std::memcpy(buffer.getWritePointer(0), output.data[0], buffer_size);
+    std::memcpy(buffer.getWritePointer(1), output.data[1], buffer_size);
+
+    return *this;
+}
+
+
 // Implementation for Spatializer
 Spatializer::Spatializer(IPLContext context, IPLAudioSettings *audioSettings) :
     context{ context },
     binaural{ context, audioSettings },
     direct{ context, audioSettings },
+    propagation{ audioSettings, 2 },
     output{}
 {
     steam_assert(
@@ -126,9 +410,10 @@ Spatializer::~Spatializer() {
     iplAudioBufferFree(context, &output);
 }
 
-Spatializer &Spatializer::setParams(Vec3 position, float minDistance) {
+Spatializer &Spatializer::setParams(Vec3 position, float minDistance, bool propagationDelay) {
     binaural.setParams(position);
     direct.setParams(context, position, minDistance);
+    propagation.setParams(position, propagationDelay);
     return *this;
 }
 
@@ -140,6 +425,8 @@ Spatializer &Spatializer::processBlock(juce::AudioBuffer<float> &buffer, int inp
         ) };
     }
 
+    propagation.processBlock(buffer, input_channel_count);
+
     IPLAudioBuffer input {
         .numChannels = std::min(input_channel_count, 2),
         .numSamples = buffer.getNumSamples(),
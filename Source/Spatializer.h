@@ -8,6 +8,12 @@ const Vec3 DEFAULT_SOURCE_POSITION{ 0.0f, 0.5f, 0.0f }; // Straight ahead
 const Vec3 DEFAULT_ORBIT_AXIS{ Vec3::up() };
 const Vec3 LISTENER_POSITION{ Vec3::origin() };
 
+constexpr float SPEED_OF_SOUND = 343.0f; // m/s, dry air at 20 degrees C
+constexpr float MAX_PROPAGATION_DELAY = 0.3f; // seconds, roughly 100m of travel
+
+constexpr int BED_AMBISONICS_ORDER = 2;
+constexpr float BED_LFE_GAIN = 0.5f; // -6dB into each ear
+
 struct BinauralEffect {
     BinauralEffect(IPLContext context, IPLAudioSettings *audioSettings);
     BinauralEffect(BinauralEffect const &) = delete;
@@ -43,6 +49,70 @@ private:
     Vec3 prevPosition;
 };
 
+// Delays the source by its travel time to the listener. The delay glides across
+// each block, which is what produces Doppler shift on moving sources.
+struct PropagationDelay {
+    PropagationDelay(IPLAudioSettings *audioSettings, int numChannels);
+    PropagationDelay(PropagationDelay const &) = delete;
+    PropagationDelay &operator=(PropagationDelay const &) = delete;
+    ~PropagationDelay() = default;
+
+    void setParams(Vec3 position, bool enable);
+    void processBlock(juce::AudioBuffer<float> &buffer, int numChannels);
+
+private:
+    float sampleRate;
+    float maxDelay; // In samples
+    float currentDelay{}, targetDelay{}; // In samples
+    bool enabled{ false };
+    bool delayed{ false }; // Whether the last block was, so a change in `enabled` crossfades over the next one
+
+    // Power-of-two ring so wrapping is a mask
+    juce::AudioBuffer<float> line;
+    int mask;
+    int writeIndex{ 0 };
+
+    // Per-block scratch, filled once and shared by every channel
+    std::vector<int> taps;
+    std::array<std::vector<float>, 4> coefficients, gathered;
+};
+
+// Renders a surround bed binaurally through virtual speakers. Every speaker is
+// encoded into one ambisonic sound field, which is decoded through the HRTF
+// once, so adding channels only adds the cheap encoding step.
+struct VirtualSpeakerBed {
+    // Direction of a bed channel, or nullopt for LFE and unsupported channels
+    static std::optional<Vec3> speakerDirection(juce::AudioChannelSet::ChannelType channel);
+    static bool supports(juce::AudioChannelSet const &layout);
+
+    VirtualSpeakerBed(IPLContext context, IPLAudioSettings *audioSettings, IPLHRTF hrtf, juce::AudioChannelSet const &layout);
+    VirtualSpeakerBed(VirtualSpeakerBed const &) = delete;
+    VirtualSpeakerBed &operator=(VirtualSpeakerBed const &) = delete;
+    ~VirtualSpeakerBed();
+
+    // Turns the whole layout about `up` so that its front faces `front`
+    VirtualSpeakerBed &setParams(Vec3 front, Vec3 up);
+    VirtualSpeakerBed &processBlock(juce::AudioBuffer<float> &buffer);
+
+private:
+    struct Speaker {
+        int channel;
+        Vec3 direction;
+        IPLAmbisonicsEncodeEffect effect;
+    };
+
+    IPLContext context;
+    IPLHRTF hrtf;
+    IPLAmbisonicsDecodeEffect decoder{};
+    IPLAudioBuffer encoded{}, soundField{}, output{};
+
+    std::vector<Speaker> speakers{};
+    std::vector<int> lfeChannels{};
+
+    // Basis of the rotated layout
+    Vec3 right{ 1.0f, 0.0f, 0.0f }, front{ Vec3::forward() }, up{ Vec3::up() };
+};
+
 struct Spatializer {
     Spatializer(IPLContext context, IPLAudioSettings *audioSettings);
     Spatializer(Spatializer &) = delete;
@@ -50,7 +120,7 @@ struct Spatializer {
     ~Spatializer();
 
     IPLHRTF const &getHrtf() const { return binaural.getHrtf(); }
-    Spatializer &setParams(Vec3 position, float minDistance);
+    Spatializer &setParams(Vec3 position, float minDistance, bool propagationDelay);
     Spatializer &processBlock(juce::AudioBuffer<float> &buffer, int input_channels);
 
 private:
@@ -59,4 +129,5 @@ private:
     
     BinauralEffect binaural;
     DirectEffect direct;
+    PropagationDelay propagation;
 };
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include "SteamAllocator.h"
+
+#include <bit>
+#include <new>
+#include <utility>
+
+struct SteamAllocator::Header {
+    SteamAllocator *owner;
+    Header *next; // Free-list link while pooled
+    void *base; // Start of the system allocation
+    size_t alignment; // Of the system allocation
+    size_t size; // Requested by the current user
+    size_t capacity; // Usable bytes after the header
+    int sizeClass; // -1 when the block isn't pooled
+};
+
+std::array<std::atomic<SteamAllocator *>, SteamAllocator::MAX_ALLOCATORS> SteamAllocator::slots{};
+
+// Four classes per octave from 64 bytes, so pooling wastes at most 25%
+static int sizeClassOf(size_t bytes, size_t &capacity, int maxOctave) {
+    if (bytes <= 64) {
+        capacity = 64;
+        return 0;
+    }
+
+    int octave = static_cast<int>(std::bit_width(bytes - 1)) - 1;
+    if (octave >= maxOctave) {
+        capacity = bytes;
+        return -1;
+    }
+
+    size_t quarter = ((bytes - 1) >> (octave - 2)) - 4;
+    capacity = (quarter + 5) << (octave - 2);
+    return 1 + (octave - 6) * 4 + static_cast<int>(quarter);
+}
+
+
+SteamAllocator::RealtimeSection::RealtimeSection(SteamAllocator &allocator) :
+    allocator{ allocator }
+{
+    allocator.realtime = true;
+}
+
+SteamAllocator::RealtimeSection::~RealtimeSection() {
+    allocator.realtime = false;
+}
+
+
+SteamAllocator::SteamAllocator() {
+    for (int i{ 0 }; i < MAX_ALLOCATORS; i++) {
+        SteamAllocator *free{ nullptr };
+        if (slots[i].compare_exchange_strong(free, this)) {
+            slot = i;
+            return;
+        }
+    }
+    jassertfalse; // More live allocators than slots
+}
+
+SteamAllocator::~SteamAllocator() {
+    // Steam Audio must have released everything by the time its allocator goes away
+    jassert(bytesLive.load() == 0);
+
+    for (auto *header : pool) {
+        while (header) {
+            auto *next = header->next;
+            ::operator delete(header->base, std::align_val_t{ header->alignment });
+            header = next;
+        }
+    }
+
+    if (slot >= 0) slots[slot] = nullptr;
+}
+
+SteamAllocatorStats SteamAllocator::getStats() const {
+    return {
+        .bytesLive = bytesLive.load(),
+        .bytesPeak = bytesPeak.load(),
+        .bytesPooled = bytesPooled.load(),
+        .allocations = allocations.load(),
+        .frees = frees.load(),
+        .systemAllocations = systemAllocations.load(),
+        .realtimeAllocations = realtimeAllocations.load(),
+    };
+}
+
+IPLAllocateFunction SteamAllocator::getAllocateCallback() const {
+    // One instantiation per slot, since the callback can only tell them apart by its address
+    static constexpr auto callbacks = []<int... Slots>(std::integer_sequence<int, Slots...>) {
+        return std::array<IPLAllocateFunction, MAX_ALLOCATORS>{ &SteamAllocator::allocate<Slots>... };
+    }(std::make_integer_sequence<int, MAX_ALLOCATORS>{});
+
+    return slot >= 0 ? callbacks[slot] : nullptr;
+}
+
+IPLFreeFunction SteamAllocator::getFreeCallback() const {
+    return slot >= 0 ? &SteamAllocator::release : nullptr;
+}
+
+template <int Slot>
+void *IPLCALL SteamAllocator::allocate(IPLsize size, IPLsize alignment) {
+    return slots[Slot].load()->allocateBlock(size, alignment);
+}
+
+void IPLCALL SteamAllocator::release(void *block) {
+    if (block == nullptr) return;
+
+    auto *header = static_cast<Header *>(block) - 1;
+    header->owner->releaseBlock(header);
+}
+
+void *SteamAllocator::allocateBlock(size_t size, size_t alignment) {
+    allocations++;
+    if (realtime) realtimeAllocations++;
+
+    size_t capacity;
+    int sizeClass = alignment <= POOL_ALIGNMENT ? sizeClassOf(size, capacity, MAX_POOLED_OCTAVE) : -1;
+    if (alignment > POOL_ALIGNMENT) capacity = size;
+
+    Header *header{ nullptr };
+    if (sizeClass >= 0) {
+        juce::SpinLock::ScopedLockType lock{ poolLock };
+        header = pool[sizeClass];
+        if (header) pool[sizeClass] = header->next;
+    }
+
+    if (header) {
+        bytesPooled -= header->capacity;
+    } else {
+        systemAllocations++;
+
+        // The header sits directly before the returned block, padded to keep the block aligned
+        size_t blockAlignment = std::max(alignment, POOL_ALIGNMENT);
+        size_t headerSpace = (sizeof(Header) + blockAlignment - 1) / blockAlignment * blockAlignment;
+        void *base = ::operator new(headerSpace + capacity, std::align_val_t{ blockAlignment }, std::nothrow);
+        if (base == nullptr) return nullptr;
+
+        header = reinterpret_cast<Header *>(static_cast<char *>(base) + headerSpace) - 1;
+        *header = Header{
+            .owner = this,
+            .next = nullptr,
+            .base = base,
+            .alignment = blockAlignment,
+            .size = 0,
+            .capacity = capacity,
+            .sizeClass = sizeClass,
+        };
+    }
+
+    header->size = size;
+    size_t live = bytesLive += size;
+    size_t peak = bytesPeak.load();
+    while (live > peak && !bytesPeak.compare_exchange_weak(peak, live)) {}
+
+    return header + 1;
+}
+
+void SteamAllocator::releaseBlock(Header *header) {
+    frees++;
+    bytesLive -= header->size;
+
+    if (header->sizeClass < 0) {
+        ::operator delete(header->base, std::align_val_t{ header->alignment });
+        return;
+    }
+
+    bytesPooled += header->capacity;
+    juce::SpinLock::ScopedLockType lock{ poolLock };
+    header->next = pool[header->sizeClass];
+    pool[header->sizeClass] = header;
+}
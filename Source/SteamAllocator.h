@@ -0,0 +1,67 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <phonon.h>
+#include <array>
+#include <atomic>
+
+struct SteamAllocatorStats {
+    size_t bytesLive, bytesPeak, bytesPooled;
+    juce::uint64 allocations, frees, systemAllocations, realtimeAllocations;
+};
+
+// Pooled, instrumented allocator for Steam Audio. The callbacks carry no user
+// data, so each live allocator claims one of MAX_ALLOCATORS slots, and hands
+// Steam Audio the allocate callback compiled for that slot. Each block records
+// its owner, so one free callback serves every slot from any thread.
+// Freed blocks stay pooled by size class, so re-preparing reuses memory.
+struct SteamAllocator {
+    static constexpr int MAX_ALLOCATORS = 64; // Live at once, one per plugin instance
+
+    // Counts allocations made until destroyed as made on the audio thread
+    struct RealtimeSection {
+        RealtimeSection(SteamAllocator &allocator);
+        RealtimeSection(RealtimeSection const &) = delete;
+        RealtimeSection &operator=(RealtimeSection const &) = delete;
+        ~RealtimeSection();
+
+    private:
+        SteamAllocator &allocator;
+    };
+
+    SteamAllocator();
+    SteamAllocator(SteamAllocator const &) = delete;
+    SteamAllocator &operator=(SteamAllocator const &) = delete;
+    ~SteamAllocator();
+
+    SteamAllocatorStats getStats() const;
+
+    // For IPLContextSettings. Both null when every slot is taken, which leaves
+    // that context on Steam Audio's own allocator, uncounted.
+    IPLAllocateFunction getAllocateCallback() const;
+    IPLFreeFunction getFreeCallback() const;
+
+private:
+    struct Header;
+
+    static constexpr size_t POOL_ALIGNMENT = 64; // Covers Steam Audio's AVX buffers
+    static constexpr int MAX_POOLED_OCTAVE = 30; // Blocks of 1GiB and up go straight to the system
+    static constexpr int NUM_SIZE_CLASSES = 1 + (MAX_POOLED_OCTAVE - 6) * 4;
+
+    static std::array<std::atomic<SteamAllocator *>, MAX_ALLOCATORS> slots;
+    int slot{ -1 };
+
+    template <int Slot>
+    static void *IPLCALL allocate(IPLsize size, IPLsize alignment);
+    static void IPLCALL release(void *block);
+
+    void *allocateBlock(size_t size, size_t alignment);
+    void releaseBlock(Header *header);
+
+    juce::SpinLock poolLock;
+    std::array<Header *, NUM_SIZE_CLASSES> pool{};
+
+    std::atomic<bool> realtime{ false };
+    std::atomic<size_t> bytesLive{}, bytesPeak{}, bytesPooled{};
+    std::atomic<juce::uint64> allocations{}, frees{}, systemAllocations{}, realtimeAllocations{};
+};
@@ -0,0 +1,150 @@
+#include "TopDownView.h"
+
+const juce::Colour BACKGROUND_COLOR = juce::Colours::black;
+const juce::Colour GRID_COLOR = juce::Colour::fromHSV(0.1f, 0.75f, 1.0f, 0.15f);
+const juce::Colour PATH_COLOR = juce::Colour::fromHSV(0.1f, 0.75f, 1.0f, 0.6f);
+const juce::Colour SOURCE_COLOR = juce::Colour::fromHSV(0.1f, 0.75f, 1.0f, 1.0f);
+const float GRID_SPACING = 0.5f;
+
+TopDownViewComponent::TopDownViewComponent(SaunaControls const &pluginState) :
+    pluginState{ pluginState }
+{
+    setOpaque(true);
+    startTimerHz(FRAME_RATE);
+}
+
+// Forward is up the screen, and height only changes the marker's size
+juce::Point<float> TopDownViewComponent::toScreen(Vec3 const &position) const {
+    auto centre = getLocalBounds().toFloat().getCentre();
+    float scale = static_cast<float>(std::min(getWidth(), getHeight())) / (2.0f * EXTENT);
+    return { centre.x + position.x * scale, centre.y - position.y * scale };
+}
+
+float TopDownViewComponent::markerRadius(Vec3 const &position) const {
+    return MARKER_RADIUS * juce::jlimit(0.5f, 2.0f, 1.0f + position.z / EXTENT);
+}
+
+juce::Rectangle<int> TopDownViewComponent::markerArea(Vec3 const &position) const {
+    float radius = markerRadius(position) + 2.0f; // Room for antialiasing
+    return juce::Rectangle<float>{ radius * 2.0f, radius * 2.0f }
+        .withCentre(toScreen(position))
+        .getSmallestIntegerContainer();
+}
+
+std::vector<float> TopDownViewComponent::currentKey() const {
+    std::vector<float> key{
+        static_cast<float>(pluginState.mode->getIndex()),
+        pluginState.speed->get(),
+        pluginState.phase->get(),
+        pluginState.orbitRadius->get(),
+        pluginState.orbitStretch->get(),
+        pluginState.orbitRotation->get(),
+        static_cast<float>(getWidth()),
+        static_cast<float>(getHeight()),
+    };
+    for (auto const *parameter : pluginState.orbitCenter) key.push_back(parameter->get());
+    for (auto const *parameter : pluginState.orbitAxis) key.push_back(parameter->get());
+    for (auto const &node : pluginState.nodes) {
+        key.insert(key.end(), { node.position.x, node.position.y, node.position.z });
+    }
+    return key;
+}
+
+// Grid, listener, and the orbit or path the source follows
+void TopDownViewComponent::redrawBackground() {
+    backgroundKey = currentKey();
+    backgroundScale = static_cast<float>(juce::Component::getApproximateScaleFactorForComponent(this));
+
+    int width = juce::roundToInt(static_cast<float>(getWidth()) * backgroundScale);
+    int height = juce::roundToInt(static_cast<float>(getHeight()) * backgroundScale);
+    if (width <= 0 || height <= 0) {
+        background = {};
+        return;
+    }
+
+    background = juce::Image{ juce::Image::RGB, width, height, false };
+    juce::Graphics graphics{ background };
+    graphics.addTransform(juce::AffineTransform::scale(backgroundScale));
+    graphics.fillAll(BACKGROUND_COLOR);
+
+    auto bounds = getLocalBounds().toFloat();
+    graphics.setColour(GRID_COLOR);
+    for (float offset{ 0.0f }; offset <= EXTENT * 2.0f; offset += GRID_SPACING) {
+        for (float sign : { -1.0f, 1.0f }) {
+            auto point = toScreen(Vec3{ sign * offset, sign * offset, 0.0f });
+            graphics.drawVerticalLine(juce::roundToInt(point.x), bounds.getY(), bounds.getBottom());
+            graphics.drawHorizontalLine(juce::roundToInt(point.y), bounds.getX(), bounds.getRight());
+        }
+    }
+
+    // Trajectory, sampled over one revolution for orbits
+    juce::Path trajectory;
+    auto mode = static_cast<SaunaMode>(pluginState.mode->getIndex());
+    if (mode == SaunaMode::Orbit && std::abs(pluginState.speed->get()) > 1.0e-6f) {
+        double period = 2.0 * juce::MathConstants<double>::pi / pluginState.speed->get();
+        for (int i{ 0 }; i <= ORBIT_POINTS; i++) {
+            double time = period * i / ORBIT_POINTS - pluginState.phase->get();
+            auto point = toScreen(pluginState.evaluate(time));
+            if (i == 0) trajectory.startNewSubPath(point);
+            else trajectory.lineTo(point);
+        }
+    } else if (mode == SaunaMode::Path) {
+        for (size_t i{ 0 }; i < pluginState.nodes.size(); i++) {
+            auto const &node = pluginState.nodes[i].position;
+            auto point = toScreen(Vec3{ node.x, node.y, node.z });
+            if (i == 0) trajectory.startNewSubPath(point);
+            else trajectory.lineTo(point);
+        }
+    }
+    graphics.setColour(PATH_COLOR);
+    graphics.strokePath(trajectory, juce::PathStrokeType{ 1.5f });
+
+    // Listener, with a tick showing which way it faces
+    auto listener = toScreen(Vec3::origin());
+    graphics.setColour(juce::Colours::white);
+    graphics.fillEllipse(juce::Rectangle<float>{ MARKER_RADIUS * 1.5f, MARKER_RADIUS * 1.5f }.withCentre(listener));
+    graphics.drawLine(listener.x, listener.y, listener.x, listener.y - MARKER_RADIUS * 2.0f, 1.5f);
+}
+
+void TopDownViewComponent::paint(juce::Graphics &graphics) {
+    if (background.isValid()) {
+        graphics.drawImageTransformed(background, juce::AffineTransform::scale(1.0f / backgroundScale));
+    } else {
+        graphics.fillAll(BACKGROUND_COLOR);
+    }
+
+    graphics.setColour(SOURCE_COLOR);
+    float radius = markerRadius(sourcePosition);
+    graphics.fillEllipse(juce::Rectangle<float>{ radius * 2.0f, radius * 2.0f }.withCentre(toScreen(sourcePosition)));
+}
+
+void TopDownViewComponent::resized() {
+    redrawBackground();
+}
+
+// Only repaints what changed: everything when the background did, otherwise just the marker
+void TopDownViewComponent::timerCallback() {
+    if (currentKey() != backgroundKey) {
+        redrawBackground();
+        repaint();
+    }
+
+    auto position = pluginState.getLastPosition();
+    if (position == sourcePosition) return;
+
+    auto area = markerArea(position);
+    repaint(sourceArea);
+    repaint(area);
+    sourcePosition = position;
+    sourceArea = area;
+}
+
+void TopDownViewComponent::mouseDown(juce::MouseEvent const &event) {
+    if (!event.mods.isPopupMenu()) return;
+
+    juce::PopupMenu menu;
+    menu.addItem("Switch to 3D view", [this]() {
+        if (onViewportRequested) onViewportRequested();
+    });
+    menu.showMenuAsync(juce::PopupMenu::Options{}.withTargetComponent(this).withMousePosition());
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+#include <vector>
+
+#include "SaunaControls.h"
+
+// Lightweight stand-in for the 3D viewport where GL is too slow, such as software renderers and
+// remote desktops. A top-down juce::Graphics view of the listener, the source, the orbit and the
+// path. Everything that doesn't move is cached in `background`, and each tick only repaints the
+// areas the source marker left and entered.
+struct TopDownViewComponent: juce::Component, juce::Timer {
+    static constexpr int FRAME_RATE = 30;
+    static constexpr float EXTENT = 3.0f; // World units from the listener to the nearest edge, as far as the grid floor reaches
+    static constexpr float MARKER_RADIUS = 6.0f;
+    static constexpr int ORBIT_POINTS = 128;
+
+    TopDownViewComponent(SaunaControls const &pluginState);
+    TopDownViewComponent(TopDownViewComponent const &) = delete;
+    TopDownViewComponent &operator=(TopDownViewComponent const &) = delete;
+    ~TopDownViewComponent() override = default;
+
+    // Asked for from the context menu
+    std::function<void()> onViewportRequested;
+
+    void paint(juce::Graphics &) override;
+    void resized() override;
+    void timerCallback() override;
+    void mouseDown(juce::MouseEvent const &) override;
+
+private:
+    SaunaControls const &pluginState;
+
+    juce::Image background; // In physical pixels
+    float backgroundScale{ 1.0f };
+    std::vector<float> backgroundKey{}; // Parameters the background was drawn with
+
+    Vec3 sourcePosition{};
+    juce::Rectangle<int> sourceArea{};
+
+    std::vector<float> currentKey() const;
+    void redrawBackground();
+
+    juce::Point<float> toScreen(Vec3 const &position) const;
+    float markerRadius(Vec3 const &position) const;
+    juce::Rectangle<int> markerArea(Vec3 const &position) const;
+};
@@ -1,22 +1,196 @@
 #include "Viewport.h"
 #include "SaunaControls.h"
+#include "Spatializer.h"
 
 const juce::Point<float> ViewportComponent::INITIAL_MOUSE{ 0.5f, 0.6f };
 const juce::Colour ViewportComponent::CLEAR_COLOR = juce::Colours::black;
 const double ViewportComponent::MOUSE_DELAY = 0.4;
-const float ICOSPHERE_SCALE = 0.2f;
+const double ViewportComponent::IDLE_FRAME_INTERVAL = 1.0 / 15.0; // Keeps the icosphere spinning while idle
+const int REPAINT_POLL_HZ = 60; // For new position samples, on the message thread
+const int ICOSPHERE_MIN_SUBDIVISIONS = 1, ICOSPHERE_MAX_SUBDIVISIONS = 3;
+const float ICOSPHERE_DETAIL_RADIUS = 64.0f; // Projected radius in pixels, doubling for each finer level
+const float LISTENER_SIZE = 0.125f;
+
+// Falling back to the 2D view
+const double SLOW_GPU_MS = 3.0 * FRAME_BUDGET_MS; // Even at MIN_RASTER_SCALE
+const int SLOW_FRAME_LIMIT = 60; // Consecutive measured frames, so a hiccup doesn't count
+const std::array<char const *, 6> SOFTWARE_RENDERERS{ "llvmpipe", "softpipe", "SwiftShader", "Software Rasterizer", "GDI Generic", "Basic Render Driver" };
+
+const double SCANOUT_FRAMES = 2.0; // From starting a render to it reaching the screen, with a swap interval of one
+const double MAX_EXTRAPOLATION = 0.25; // Seconds past the newest sample, beyond which the audio has likely stopped
+const size_t POSITION_HISTORY = 8;
+
+const double TRAIL_HISTORY = 2.0; // Seconds of past positions shown behind the source
+const double TRAIL_PREDICTION = 1.0; // Seconds of orbit shown ahead of the source
+const int TRAIL_PREDICTION_POINTS = 48;
+const size_t TRAIL_MAX_HISTORY = 512;
+const float TRAIL_PREDICTION_OPACITY = 0.4f;
+const juce::Colour TRAIL_COLOR = juce::Colour::fromHSV(0.1f, 0.75f, 1.0f, 1.0f);
+// Room for several frames of the longest trail before the stream buffer is orphaned
+const GLsizei TRAIL_STREAM_VERTICES = 8 * 2 * static_cast<GLsizei>(TRAIL_MAX_HISTORY + TRAIL_PREDICTION_POINTS);
 
 ViewportComponent::ViewportComponent(SaunaControls const &pluginState) :
     pluginState{ pluginState },
     juce::OpenGLAppComponent{},
     gridFloorShader{ nullptr },
-    startTime{ juce::Time::getCurrentTime() },
-    lastUpdateTime{ startTime },
-    vBlankTimer{ this, [this](){ update(); } }
-{};
+    startTime{ monotonicSeconds() },
+    lastAdvanceTime{ startTime }
+{
+    pointer.post(INITIAL_MOUSE);
+
+    // The base class attached before a share target could be set, so attaching starts over
+    openGLContext.detach();
+    attachmentWatcher.emplace(*this);
+    updateAttachment();
+
+    // Frames are only rendered when asked for, see `advance` and `timerCallback`, so an idle
+    // editor doesn't wake the GL thread on every vsync
+    openGLContext.setContinuousRepainting(false);
+};
+
+// Like JUCE's own test for attaching, a minimised window keeps its context
+static bool isShowingOrMinimised(juce::Component const &component) {
+    if (!component.isVisible()) return false;
+    if (auto *parent = component.getParentComponent()) return isShowingOrMinimised(*parent);
+    return component.getPeer() != nullptr;
+}
+
+// JUCE keeps an attachment across hiding and creates the native context again on showing, with
+// whatever share target was set back then. Attaching only when the context is created straight
+// away means the target is looked up, and pinned, right before it's used.
+void ViewportComponent::updateAttachment() {
+    bool attachable = getWidth() > 0 && getHeight() > 0 && isShowingOrMinimised(*this);
+    if (attachable == attached) return;
+    attached = attachable;
+
+    if (attachable) {
+        // Another open viewport already has the programs, textures and meshes, so share its objects
+        shareTarget = GLShareGroup::instance().pinShareTarget();
+        openGLContext.setNativeSharedContext(shareTarget);
+
+        // Starts before the context, so decoding overlaps with its creation and shader loading
+        if (!shareTarget && !assets) assets = ViewportAssets::request();
+
+        openGLContext.attachTo(*this);
+        startTimerHz(REPAINT_POLL_HZ);
+    } else {
+        stopTimer();
+        openGLContext.detach();
+        unpinShareTarget();
+    }
+}
+
+// Unless the context joined the group, which released the pin already
+void ViewportComponent::unpinShareTarget() {
+    if (auto *target = shareTarget.exchange(nullptr)) GLShareGroup::instance().unpin(target);
+}
+
+// Averages 2x2 texels, wrapping around odd edges the way GL_REPEAT samples them
+static std::vector<juce::uint8> halveWrapped(std::vector<juce::uint8> const &pixels, int width, int height) {
+    int halfWidth = std::max(width / 2, 1), halfHeight = std::max(height / 2, 1);
+    std::vector<juce::uint8> half(static_cast<size_t>(halfWidth) * static_cast<size_t>(halfHeight));
+
+    for (int y{ 0 }; y < halfHeight; y++) {
+        int y0 = (2 * y) % height, y1 = (2 * y + 1) % height;
+        for (int x{ 0 }; x < halfWidth; x++) {
+            int x0 = (2 * x) % width, x1 = (2 * x + 1) % width;
+            int sum = pixels[y0 * width + x0] + pixels[y0 * width + x1] + pixels[y1 * width + x0] + pixels[y1 * width + x1];
+            half[y * halfWidth + x] = static_cast<juce::uint8>((sum + 2) / 4);
+        }
+    }
+    return half;
+}
+
+// RGTC1 with the block's extremes as endpoints and the six interpolated values between them.
+// Texels past the edge of small levels repeat the last row or column; GL ignores them anyway.
+static std::vector<juce::uint8> encodeRGTC1(std::vector<juce::uint8> const &pixels, int width, int height) {
+    int blocksWide = (width + 3) / 4, blocksHigh = (height + 3) / 4;
+    std::vector<juce::uint8> blocks;
+    blocks.reserve(static_cast<size_t>(blocksWide) * static_cast<size_t>(blocksHigh) * 8);
+
+    for (int blockY{ 0 }; blockY < blocksHigh; blockY++) {
+        for (int blockX{ 0 }; blockX < blocksWide; blockX++) {
+            std::array<int, 16> texels;
+            for (int i{ 0 }; i < 16; i++) {
+                int x = std::min(blockX * 4 + i % 4, width - 1), y = std::min(blockY * 4 + i / 4, height - 1);
+                texels[i] = pixels[y * width + x];
+            }
+            auto [low, high] = std::minmax_element(texels.begin(), texels.end());
+            int red0 = *high, red1 = *low;
+
+            // Codes 0 and 1 are the endpoints, 2 to 7 step from red0 towards red1
+            juce::uint64 indices{ 0 };
+            if (red0 > red1) {
+                for (int i{ 0 }; i < 16; i++) {
+                    int step = ((red0 - texels[i]) * 7 + (red0 - red1) / 2) / (red0 - red1);
+                    juce::uint64 code = step == 0 ? 0 : step == 7 ? 1 : step + 1;
+                    indices |= code << (3 * i);
+                }
+            }
+
+            blocks.push_back(static_cast<juce::uint8>(red0));
+            blocks.push_back(static_cast<juce::uint8>(red1));
+            for (int i{ 0 }; i < 6; i++) {
+                blocks.push_back(static_cast<juce::uint8>(indices >> (8 * i)));
+            }
+        }
+    }
+    return blocks;
+}
+
+CompressedMipChain CompressedMipChain::fromImage(juce::Image const &source) {
+    jassert(source.isValid());
+
+    int width = source.getWidth(), height = source.getHeight();
+    std::vector<juce::uint8> pixels(static_cast<size_t>(width) * static_cast<size_t>(height));
+    juce::Image::BitmapData bitmap{ source, juce::Image::BitmapData::readOnly };
+    for (int y{ 0 }; y < height; y++) {
+        for (int x{ 0 }; x < width; x++) {
+            pixels[y * width + x] = bitmap.getPixelColour(x, y).getRed();
+        }
+    }
+
+    CompressedMipChain chain;
+    while (true) {
+        chain.levels.push_back({ width, height, encodeRGTC1(pixels, width, height) });
+        if (width == 1 && height == 1) break;
+
+        pixels = halveWrapped(pixels, width, height);
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+    return chain;
+}
+
+ViewportAssets ViewportAssets::prepare() {
+    ViewportAssets prepared{
+        .perlin = CompressedMipChain::fromImage(
+            juce::ImageFileFormat::loadFrom(BinaryData::perlin_jpg, BinaryData::perlin_jpgSize)
+        )
+    };
+
+    for (int subdivisions{ ICOSPHERE_MIN_SUBDIVISIONS }; subdivisions <= ICOSPHERE_MAX_SUBDIVISIONS; subdivisions++) {
+        prepared.icosphereLevels.push_back(GLMesh::icosphereVertices(subdivisions, juce::Colours::white));
+    }
+    return prepared;
+}
+
+std::shared_ptr<std::shared_future<ViewportAssets>> ViewportAssets::request() {
+    static std::mutex mutex;
+    static std::weak_ptr<std::shared_future<ViewportAssets>> pending;
+
+    std::scoped_lock lock{ mutex };
+    if (auto existing = pending.lock()) return existing;
+
+    auto future = std::make_shared<std::shared_future<ViewportAssets>>(std::async(std::launch::async, &ViewportAssets::prepare).share());
+    pending = future;
+    return future;
+}
 
 ViewportComponent::~ViewportComponent() {
+    attachmentWatcher.reset();
     shutdownOpenGL();
+    unpinShareTarget();
 }
 
 void ViewportComponent::initialise() {
@@ -25,47 +199,135 @@ void ViewportComponent::initialise() {
 
     recomputeViewportSize();
 
-	perlin.emplace(
-        juce::ImageCache::getFromMemory(BinaryData::perlin_jpg, BinaryData::perlin_jpgSize),
-        juce::gl::GL_RED
-    );
+    // Programs and static buffers are only created by the first viewport, the rest share them
+    shared = GLShareGroup::instance().join(openGLContext.getRawContext(), shareTarget.exchange(nullptr), [this]() { return createSharedResources(); });
+    gridFloorShader       = shared->gridFloorShader;
+    billboardShader       = shared->billboardShader;
+    trailShader           = shared->trailShader;
+    icosphereShader       = shared->icosphereShader;
+    downsampleShader      = shared->downsampleShader;
+    msaaResolveShader     = shared->msaaResolveShader;
+    cinematicShader       = shared->cinematicShader;
+    bloomDownsampleShader = shared->bloomDownsampleShader;
+    bloomBlurShader       = shared->bloomBlurShader;
+    bloomUpsampleShader   = shared->bloomUpsampleShader;
 
-    tryLoadShader(gridFloorShader, openGLContext, BinaryData::standard_vert_glsl, BinaryData::gridfloor_frag_glsl, "gridFloorShader");
     gridFloor.emplace(
-        GLMesh::quad(juce::Colour::fromHSV(0.1f, 0.75f, 1.0f, 1.0f)),  
+        GLMesh{ shared->gridFloorQuad },
         gridFloorShader,
         rotationTranslationScale({}, {}, 3.0f)
-    );  
-
-    tryLoadShader(ballShader, openGLContext, BinaryData::billboard_vert_glsl, BinaryData::ball_frag_glsl, "ballShader");
-    ball.emplace(
-        GLMesh::quad(juce::Colours::white),  
-        ballShader,
-        rotationTranslationScale({}, {}, 0.125f)
     );
+    billboards.emplace(billboardShader);
+
+    trail.emplace(TRAIL_STREAM_VERTICES);
 
-    tryLoadShader(icosphereShader, openGLContext, BinaryData::standard_vert_glsl, BinaryData::icosphere_frag_glsl, "meshDebugShader");
-	icosphere.emplace(
-		GLMesh::icosphere(1, juce::Colours::white),
-		icosphereShader,
-        rotationTranslationScale({}, {}, ICOSPHERE_SCALE),
-        &perlin.value()
-	);
-
-	tryLoadShader(downsampleShader,      openGLContext, BinaryData::postprocess_vert_glsl, BinaryData::downsample_frag_glsl, "downsampleShader");
-    tryLoadShader(cinematicShader,       openGLContext, BinaryData::postprocess_vert_glsl, BinaryData::cinematic_frag_glsl, "cinematicShader");  
-    tryLoadShader(gaussianShader,        openGLContext, BinaryData::postprocess_vert_glsl, BinaryData::gaussian_frag_glsl, "gaussianShader");  
-    tryLoadShader(bloomAccumulateShader, openGLContext, BinaryData::postprocess_vert_glsl, BinaryData::bloomAccumulate_frag_glsl, "bloomAccumulateShader");
     postprocess.emplace(  
         downsampleShader,  
+        msaaResolveShader,
         cinematicShader,  
-        gaussianShader,  
-        bloomAccumulateShader,  
+        bloomDownsampleShader,  
+        bloomBlurShader,  
+        bloomUpsampleShader,  
         juce::Point<int>{ componentBounds.getWidth(), componentBounds.getHeight() },  
         RASTER_SUPERSAMPLE  
     );
 
 	juce::gl::glHint(juce::gl::GL_FRAGMENT_SHADER_DERIVATIVE_HINT, juce::gl::GL_NICEST);
+
+    // Blocks each swap on the display's refresh, which paces `advance` while it keeps requesting frames
+    openGLContext.setSwapInterval(1);
+
+    frameUniforms.emplace();
+    drawUniforms.emplace();
+
+    multisampleSupported = GLMultisampleBuffer::maxSamples() > 0;
+
+    // Without timings the raster stays at full RASTER_SUPERSAMPLE
+    timerQueriesSupported = GLTimerQuery::isSupported();
+    if (timerQueriesSupported) {
+        profiler.emplace();
+    }
+    juce::String renderer{ reinterpret_cast<char const *>(juce::gl::glGetString(juce::gl::GL_RENDERER)) };
+    frameTimes.setRenderer(renderer);
+
+    // Software GL spends whole cores on the HDR scene, so don't wait for it to prove slow
+    for (auto *name : SOFTWARE_RENDERERS) {
+        if (renderer.containsIgnoreCase(name)) requestTopDown(true);
+    }
+}
+
+void ViewportSharedResources::loadPrograms() {
+    tryLoadShader(gridFloorShader,       BinaryData::standard_vert_glsl, BinaryData::gridfloor_frag_glsl, "gridFloorShader");
+    tryLoadShader(billboardShader,       BinaryData::billboardInstanced_vert_glsl, BinaryData::ball_frag_glsl, "billboardShader");
+    tryLoadShader(trailShader,           BinaryData::trail_vert_glsl, BinaryData::trail_frag_glsl, "trailShader");
+    tryLoadShader(icosphereShader,       BinaryData::icosphere_vert_glsl, BinaryData::icosphere_frag_glsl, "icosphereShader", BinaryData::icosphere_geom_glsl);
+	tryLoadShader(downsampleShader,      BinaryData::postprocess_vert_glsl, BinaryData::downsample_frag_glsl, "downsampleShader");
+    tryLoadShader(msaaResolveShader,     BinaryData::postprocess_vert_glsl, BinaryData::msaaResolve_frag_glsl, "msaaResolveShader");
+    tryLoadShader(cinematicShader,       BinaryData::postprocess_vert_glsl, BinaryData::cinematic_frag_glsl, "cinematicShader");
+    tryLoadShader(bloomDownsampleShader, BinaryData::postprocess_vert_glsl, BinaryData::bloomDownsample_frag_glsl, "bloomDownsampleShader");
+    tryLoadShader(bloomBlurShader,       BinaryData::postprocess_vert_glsl, BinaryData::bloomBlur_frag_glsl, "bloomBlurShader");
+    tryLoadShader(bloomUpsampleShader,   BinaryData::postprocess_vert_glsl, BinaryData::bloomUpsample_frag_glsl, "bloomUpsampleShader");
+
+    // In the order of the texture slots they're bound to
+    bindSamplers(*icosphereShader,       { "texture0" });
+    bindSamplers(*downsampleShader,      { "renderedImage" });
+    bindSamplers(*msaaResolveShader,     { "renderedImage" });
+    bindSamplers(*cinematicShader,       { "sceneImage", "bloomTexture" });
+    bindSamplers(*bloomDownsampleShader, { "sourceTexture" });
+    bindSamplers(*bloomBlurShader,       { "sourceTexture" });
+    bindSamplers(*bloomUpsampleShader,   { "sourceTexture" });
+}
+
+// Called with the new context current, while GLShareGroup holds its lock
+std::shared_ptr<ViewportSharedResources> ViewportComponent::createSharedResources() {
+    auto resources = std::make_shared<ViewportSharedResources>();
+
+    resources->loadPrograms();
+    resources->gridFloorQuad = GLMesh::quad(juce::Colour::fromHSV(0.1f, 0.75f, 1.0f, 1.0f)).buffers;
+
+    // Contexts sharing these only see complete objects once the commands have finished
+    juce::gl::glFinish();
+    return resources;
+}
+
+// Returns false while the worker is still preparing
+bool ViewportComponent::tryUploadAssets() {
+    if (icosphere) return true;
+
+    std::vector<std::shared_ptr<GLMeshBuffers const>> levels;
+    {
+        std::scoped_lock lock{ shared->assetsLock };
+
+        if (!shared->perlin) {
+            if (!assets) assets = ViewportAssets::request(); // Sharing fell through after all
+            if (assets->wait_for(std::chrono::seconds{ 0 }) != std::future_status::ready) return false;
+
+            auto const &prepared = assets->get();
+            shared->perlin = std::make_shared<GLImageTexture const>(prepared.perlin);
+            for (size_t i{ 0 }; i < prepared.icosphereLevels.size(); i++) {
+                int subdivisions = ICOSPHERE_MIN_SUBDIVISIONS + static_cast<int>(i);
+                shared->icosphereLevels.push_back(std::make_shared<GLMeshBuffers const>(
+                    prepared.icosphereLevels[i],
+                    IcosphereGeometry::level(subdivisions).indices
+                ));
+            }
+
+            // Other contexts may draw with them as soon as the lock is released
+            juce::gl::glFinish();
+        }
+
+        perlin = shared->perlin;
+        levels = shared->icosphereLevels;
+    }
+    assets.reset();
+
+    icosphere.emplace(GLMesh{ levels.front() }, icosphereShader, icosphereMatrix, perlin.get());
+    for (size_t i{ 1 }; i < levels.size(); i++) {
+        icosphere->details.emplace_back(levels[i]);
+    }
+
+    sceneDirty = true;
+    return true;
 }
 
 void ViewportComponent::recomputeViewportSize() {
@@ -74,33 +336,125 @@ void ViewportComponent::recomputeViewportSize() {
     // Cannot resize postprocess buffers here because OpenGL context is not active in `resized`
 }
 
-// Called by `vBlankTimer`
-void ViewportComponent::update() {
-    repaint(); // Request
-    juce::Time now = juce::Time::getCurrentTime();
+// Called on the GL thread before each frame, marks the scene dirty only when something visible changed
+void ViewportComponent::advance() {
+    double now = monotonicSeconds();
+
+    float delta = static_cast<float>(now - lastAdvanceTime);
+    secondsElapsed = static_cast<float>(now - startTime);
+    framePeriod += (juce::jlimit(0.0, 0.1, now - lastAdvanceTime) - framePeriod) * 0.1;
 
-    float delta = static_cast<float>((now - lastUpdateTime).inSeconds());
-    secondsElapsed = static_cast<float>((now - startTime).inSeconds());
+    auto mousePosition = pointer.position();
+    double enteredAt = pointer.enteredAt.load();
 
+    bool mouseEasing{ false };
     if (
         (smoothMouse - INITIAL_MOUSE).getDistanceFromOrigin() > 0.0001
-        || mouseEntered && (now - *mouseEntered).inSeconds() > MOUSE_DELAY
+        || enteredAt >= 0.0 && now - enteredAt > MOUSE_DELAY
     ) {
+        mouseEasing = (smoothMouse - mousePosition).getDistanceFromOrigin() > 0.0001;
         smoothMouse = expEase(smoothMouse, mousePosition, 16.0, delta);
     }
 
-    if (icosphere) {
-        icosphere->modelMatrix = rotationTranslationScale(
-            Vec3{ 0.0f, 0.0f, secondsElapsed * 1.0f },
-            pluginState.getLastPosition(),
-            ICOSPHERE_SCALE
-        );
+    auto position = predictPosition(now + SCANOUT_FRAMES * framePeriod);
+    displayedPosition = position;
+    bool moved = !(position == renderedPosition);
+
+    icosphereMatrix = rotationTranslationScale(
+        Vec3{ 0.0f, 0.0f, secondsElapsed * 1.0f },
+        position,
+        ICOSPHERE_SCALE
+    );
+
+    // Animation alone only needs a low frame rate
+    bool animationDue = now - lastSceneTime >= IDLE_FRAME_INTERVAL;
+
+    if (moved || mouseEasing || sizeChanged.exchange(false) || animationDue) {
+        renderedPosition = position;
+        lastSceneTime = now;
+        sceneDirty = true;
+    }
+
+    // Frames keep coming while anything is in motion, once it settles the timer and input take over
+    bool mouseWaiting = enteredAt >= 0.0 && now - enteredAt <= MOUSE_DELAY;
+    if (moved || mouseEasing || mouseWaiting) openGLContext.triggerRepaint();
+
+    lastAdvanceTime = now;
+}
+
+// Wakes the GL thread for what `advance` can't see coming: a new position from the audio thread,
+// and the next frame of the idle animation
+void ViewportComponent::timerCallback() {
+    double now = monotonicSeconds();
+    double audibleAt = pluginState.getLastSample().audibleAt;
+
+    bool sampleArrived = audibleAt != polledAudibleAt;
+    polledAudibleAt = audibleAt;
+    if (sampleArrived || now - idleRepaintTime >= IDLE_FRAME_INTERVAL) {
+        idleRepaintTime = now;
+        openGLContext.triggerRepaint();
+    }
+}
+
+// Deterministic modes are evaluated at the playhead time matching `scanoutTime`, anything else
+// is interpolated between the samples around it, or extrapolated a little past the newest.
+// Once no sample has arrived for MAX_EXTRAPOLATION the audio has stopped, so the newest is shown as is.
+Vec3 ViewportComponent::predictPosition(double scanoutTime) {
+    auto sample = pluginState.getLastSample();
+
+    // Samples from before starting or stopping would interpolate across the jump
+    if (!positionHistory.empty() && positionHistory.back().playing != sample.playing) positionHistory.clear();
+
+    if (positionHistory.empty() || positionHistory.back().audibleAt != sample.audibleAt) {
+        positionHistory.push_back(sample);
+        if (positionHistory.size() > POSITION_HISTORY) positionHistory.pop_front();
+    }
 
-        auto lastPosition = pluginState.getLastPosition();
-		DBG("Icosphere position: " << lastPosition.x << ", " << lastPosition.y << ", " << lastPosition.z);
+    bool stale = scanoutTime > sample.audibleAt + MAX_EXTRAPOLATION;
+    double ahead = sample.playing && !stale ? scanoutTime - sample.audibleAt : 0.0;
+    displayedPlayheadTime = sample.time + ahead;
+    if (pluginState.isDeterministic()) {
+        return pluginState.evaluate(displayedPlayheadTime);
     }
 
-    lastUpdateTime = now;
+    if (positionHistory.size() < 2 || stale) return sample.position;
+
+    size_t after{ 1 };
+    while (after + 1 < positionHistory.size() && positionHistory[after].audibleAt < scanoutTime) after++;
+
+    auto const &first = positionHistory[after - 1], &second = positionHistory[after];
+    double span = second.audibleAt - first.audibleAt;
+    if (span <= 0.0) return second.position;
+
+    double offset = juce::jlimit(0.0, span + MAX_EXTRAPOLATION, scanoutTime - first.audibleAt);
+    return first.position + (second.position - first.position) * static_cast<float>(offset / span);
+}
+
+juce::Matrix3D<float> ViewportComponent::projectionFor(juce::Point<int> size) {
+    float halfWidth = 0.25f;
+    float halfHeight = halfWidth * static_cast<float>(size.y) / static_cast<float>(std::max(size.x, 1));
+
+    return juce::Matrix3D<float>::fromFrustum(
+        -halfWidth, halfWidth,
+        -halfHeight, halfHeight,
+        0.5f, 10.0f
+    );
+}
+
+juce::Matrix3D<float> ViewportComponent::viewFor(juce::Point<float> mouse) {
+    const float pi = juce::MathConstants<float>::pi;
+
+    juce::Matrix3D<float> radius = juce::Matrix3D<float>::fromTranslation({ 0.0f, 0.0f, -5.0f });
+    juce::Matrix3D<float> pivot = radius.rotation({
+        // altitude
+        (1.0f - mouse.y) * -pi,
+        0.0f,
+        // Turntable
+        pi + (mouse.x * 2.0f + 1.0f) * pi / 2.0f
+    });
+
+    juce::Matrix3D<float> lift = juce::Matrix3D<float>::fromTranslation({ 0.0f, 0.0f, -0.25f });
+    return radius * pivot * lift;
 }
 
 void ViewportComponent::render() {
@@ -109,119 +463,331 @@ void ViewportComponent::render() {
     jassert(juce::OpenGLHelpers::isContextActive());
     jassert(postprocess);
     jassert(gridFloor);
-    jassert(ball);
-
-    juce::Matrix3D<float> projectionMatrix{ [this]() {
-        float halfWidth = 0.25f;
-        float halfHeight = halfWidth * getLocalBounds().toFloat().getAspectRatio(false);
-
-        return juce::Matrix3D<float>::fromFrustum(
-            -halfWidth, halfWidth,
-            -halfHeight, halfHeight,
-            0.5f, 10.0f
-        );
-    }() };
-
-    juce::Matrix3D<float> viewMatrix{ [this]() {
-        const float pi = juce::MathConstants<float>::pi;
-
-        juce::Matrix3D<float> radius = juce::Matrix3D<float>::fromTranslation({ 0.0f, 0.0f, -5.0f });
-        juce::Matrix3D<float> pivot = radius.rotation({
-            // altitude
-            (1.0f - smoothMouse.y) * -pi,
-            0.0f,
-            // Turntable
-            pi + (smoothMouse.x * 2.0f + 1.0f) * pi / 2.0f
-        });
-
-        juce::Matrix3D<float> lift = juce::Matrix3D<float>::fromTranslation({ 0.0f, 0.0f, -0.25f });
-        return radius * pivot * lift;
-    }() };
-
-    const auto draw{ [this, &projectionMatrix, &viewMatrix](GLMeshObject const &mesh) {
-        mesh.shader->use();
-
-        if (mesh.uniforms.projectionMatrix.uniformID >= 0) {
-            mesh.uniforms.projectionMatrix.setMatrix4(projectionMatrix.mat, 1, false);
-        }
-        if (mesh.uniforms.viewMatrix.uniformID >= 0) {
-            mesh.uniforms.viewMatrix.setMatrix4(viewMatrix.mat, 1, false);
-        }
-        if (mesh.uniforms.modelMatrix.uniformID >= 0) {
-            mesh.uniforms.modelMatrix.setMatrix4(mesh.modelMatrix.mat, 1, false);
-        }
-		if (mesh.texture0 && mesh.uniforms.texture0.uniformID >= 0) {
-			mesh.uniforms.texture0.set(0);
-            mesh.texture0->bind(0);
-		}
-		if (mesh.uniforms.time.uniformID >= 0) {
-			mesh.uniforms.time.set(secondsElapsed);
-		}
+    jassert(billboards);
+
+    // JUCE keeps its own vertex array bound for component painting
+    GLint juceVertexArray{ 0 };
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &juceVertexArray);
+    glState.beginFrame();
+
+    const auto endFrame{ [this, juceVertexArray]() {
+        // Reset the bindings so child Components draw correctly
+        glBindVertexArray(static_cast<GLuint>(juceVertexArray));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glActiveTexture(GL_TEXTURE0);
+    } };
 
-        glBindBuffer(GL_ARRAY_BUFFER, mesh.mesh.vertexBuffer);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.mesh.indexBuffer);
+    advance();
 
-        mesh.attribs.enable();
-        mesh.mesh.drawElements();
-        mesh.attribs.disable();
+    // A plain frame stands in until the worker has prepared the assets
+    if (!tryUploadAssets()) {
+        juce::OpenGLHelpers::clear(CLEAR_COLOR);
+        endFrame();
+        openGLContext.triggerRepaint();
+        return;
+    }
+
+    juce::Point<int> size{ componentBounds.getWidth(), componentBounds.getHeight() };
+    bool resized = postprocess->sizeTo(size, RASTER_SUPERSAMPLE, antiAliasing);
+
+    // Nothing changed since the last scene, so the composited image is copied again
+    if (!sceneDirty.exchange(false) && !resized) {
+        postprocess->present(glState, 0);
+        if (showProfiler) drawProfilerOverlay();
+        endFrame();
+        return;
+    }
+
+    // Adapt the raster resolution to the GPU time of earlier frames
+    if (profiler && profiler->collect()) {
+        double sceneMilliseconds = profiler->milliseconds("Scene");
+        resolution.postprocessMilliseconds = profiler->total() - sceneMilliseconds;
+        resolution.update(sceneMilliseconds);
+        frameTimes.add(profiler->total(), profiler->breakdown());
+
+        // Too slow on the GPU even at the lowest raster scale. Swap timing can't tell this apart
+        // from the OS throttling a hidden window, so without timer queries there's no fallback.
+        bool slow = profiler->total() > SLOW_GPU_MS && resolution.getScale() <= MIN_RASTER_SCALE;
+        slowFrames = slow ? slowFrames + 1 : 0;
+        if (slowFrames >= SLOW_FRAME_LIMIT) requestTopDown(true);
+    }
+    postprocess->setRasterScale(resolution.getScale());
+
+    ViewportFrame frame{
+        .projection = projectionFor(size),
+        .view = viewFor(smoothMouse),
+        .icosphereModel = icosphereMatrix,
+        .size = size,
+        .secondsElapsed = secondsElapsed,
+        .trail = true
+    };
+    renderScene(frame, *postprocess, 0, profiler ? &*profiler : nullptr); // 0 is the presentation buffer
+    sceneCounters = glState.getCounters();
+    if (showProfiler) drawProfilerOverlay();
+
+    endFrame();
+}
+
+// Draws the scene into `target`'s raster and post-processes it into `outputBuffer`
+void ViewportComponent::renderScene(ViewportFrame const &frame, PostProcess &target, GLuint outputBuffer, GLPassProfiler *passProfiler) {
+    const auto draw{ [this](GLMeshObject const &mesh) {
+        glState.useProgram(*mesh.shader);
+        drawUniforms->update({ .modelMatrix = std::to_array(mesh.modelMatrix.mat) });
+		if (mesh.texture0) {
+            mesh.texture0->bind(glState, 0);
+		}
+
+        glState.drawElements(mesh.currentMesh());
     } };
 
-    postprocess->sizeTo({ componentBounds.getWidth(), componentBounds.getHeight() }, RASTER_SUPERSAMPLE);
+    frameUniforms->update(frame.projection, frame.view, frame.secondsElapsed);
+
+    // Pick the icosphere's level of detail from its radius on screen
+    if (icosphere) {
+        icosphere->modelMatrix = frame.icosphereModel;
+
+        auto const &model = icosphere->modelMatrix.mat;
+        auto const &view = frame.view.mat;
+        float viewDepth = -(view[2] * model[12] + view[6] * model[13] + view[10] * model[14] + view[14]);
+        float radius = ICOSPHERE_SCALE * frame.projection.mat[5] / std::max(viewDepth, 0.001f)
+            * static_cast<float>(frame.size.y) / 2.0f;
+
+        size_t detail{ 0 };
+        for (float threshold{ ICOSPHERE_DETAIL_RADIUS }; detail < icosphere->details.size() && radius >= threshold; threshold *= 2.0f) {
+            detail++;
+        }
+        icosphere->detail = detail;
+    }
 
     /* ===================================== */
     /* Scene rendering */
 
-    postprocess->rasterBuffer.setRenderTarget();
+    if (passProfiler) {
+        passProfiler->beginFrame();
+        passProfiler->begin("Scene");
+    }
+
+    target.setSceneTarget();
 
-    glDepthMask(GL_TRUE);
-    glEnable(GL_DEPTH_TEST);
+    glState.setDepth(true, true);
+    glState.setAdditiveBlend(false);
 
     // Clear frame, depth, stencil. Must happen after re-enabling depth mask
     juce::OpenGLHelpers::clear(CLEAR_COLOR);
 
-    draw(ball.value());
-	draw(icosphere.value());
+    // Listener, then any other markers as they're added to the batch
+    billboards->clear();
+    billboards->add(LISTENER_POSITION, LISTENER_SIZE, juce::Colours::white);
+    for (auto const &marker : frame.markers) {
+        billboards->add(marker.position, marker.size, marker.colour);
+    }
+    billboards->draw(glState);
 
-    // Additive rendering
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_ONE, GL_ONE);
-    glBlendEquation(GL_FUNC_ADD);
+	draw(icosphere.value());
 
-    // Read-only depth buffer for transparent elements
-    glDepthMask(GL_FALSE);
+    // Additive rendering, with a read-only depth buffer for transparent elements
+    glState.setAdditiveBlend(true);
+    glState.setDepth(true, false);
 
     draw(gridFloor.value());
+    if (frame.trail) drawTrail();
 
-    // Apply postprocessing
-	postprocess->process(0, false); // 0 is the presentation buffer
+    // Apply postprocessing, which times its own passes
+	target.process(glState, outputBuffer, false, passProfiler);
+}
 
-    // Reset the element buffers so child Components draw correctly
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+// Latest GPU time of each pass over the frame and the GL work of the last scene,
+// with a graph of recent frame totals against FRAME_BUDGET_MS
+void ViewportComponent::drawProfilerOverlay() {
+    const float rowHeight = 14.0f, width = 220.0f, graphHeight = 40.0f, margin = 8.0f;
+    const size_t graphFrames = 110;
+
+    auto context = juce::createOpenGLGraphicsContext(openGLContext, componentBounds.getWidth(), componentBounds.getHeight());
+    if (!context) return;
+
+    juce::Graphics g{ *context };
+    g.addTransform(juce::AffineTransform::scale(static_cast<float>(openGLContext.getRenderingScale())));
+
+    auto passes = frameTimes.passes();
+    auto recent = frameTimes.recent(graphFrames);
+
+    juce::Rectangle<float> panel{ margin, margin, width, rowHeight * static_cast<float>(passes.size() + 4) + graphHeight + margin * 2.0f };
+    g.setColour(juce::Colours::black.withAlpha(0.6f));
+    g.fillRoundedRectangle(panel, 4.0f);
+    g.setFont(rowHeight - 3.0f);
+
+    auto area = panel.reduced(margin);
+    auto drawRow{ [&](juce::String const &name, double milliseconds, juce::Colour colour) {
+        auto row = area.removeFromTop(rowHeight);
+        float fraction = static_cast<float>(std::min(milliseconds / FRAME_BUDGET_MS, 1.0));
+        g.setColour(colour.withAlpha(0.35f));
+        g.fillRect(row.withWidth(row.getWidth() * fraction));
+        g.setColour(colour);
+        g.drawText(name, row, juce::Justification::centredLeft);
+        g.drawText(juce::String(milliseconds, 3) + " ms", row, juce::Justification::centredRight);
+    } };
+
+    double total{ 0.0 };
+    for (auto const &[name, milliseconds] : passes) {
+        drawRow(name, milliseconds, juce::Colours::white);
+        total += milliseconds;
+    }
+    drawRow("GPU frame", total, total > FRAME_BUDGET_MS ? juce::Colours::orange : TRAIL_COLOR);
+
+    // Counted by glState over the whole scene, so they only change when it's redrawn
+    g.setColour(juce::Colours::white.withAlpha(0.7f));
+    g.drawText(juce::String(sceneCounters.draws) + " draws, " + juce::String(sceneCounters.stateChanges) + " state changes ("
+        + juce::String(sceneCounters.skipped) + " skipped)", area.removeFromTop(rowHeight), juce::Justification::centredLeft);
+    g.drawText(juce::String(static_cast<double>(sceneCounters.intermediateBytes) / (1024.0 * 1024.0), 2) + " MiB through offscreen targets",
+        area.removeFromTop(rowHeight), juce::Justification::centredLeft);
+    g.drawText(juce::String(postprocess->targetAllocations()) + " render targets allocated",
+        area.removeFromTop(rowHeight), juce::Justification::centredLeft);
+
+    // One bar per frame, with the budget at half height
+    auto graph = area.removeFromBottom(graphHeight);
+    float barWidth = graph.getWidth() / static_cast<float>(graphFrames);
+    for (size_t i{ 0 }; i < recent.size(); i++) {
+        float height = std::min(static_cast<float>(recent[i] / (2.0 * FRAME_BUDGET_MS)), 1.0f) * graph.getHeight();
+        g.setColour(recent[i] > FRAME_BUDGET_MS ? juce::Colours::orange : juce::Colours::white.withAlpha(0.7f));
+        g.fillRect(graph.getX() + barWidth * static_cast<float>(i), graph.getBottom() - height, std::max(barWidth - 1.0f, 1.0f), height);
+    }
+    g.setColour(juce::Colours::white.withAlpha(0.4f));
+    g.drawHorizontalLine(static_cast<int>(graph.getCentreY()), graph.getX(), graph.getRight());
+}
+
+// Streams the recent and predicted path of the source as a camera-facing ribbon
+void ViewportComponent::drawTrail() {
+    using namespace juce::gl;
+
+    double now = monotonicSeconds();
+
+    auto position = displayedPosition;
+    if (trailHistory.empty() || !(trailHistory.back().position == position)) {
+        trailHistory.push_back({ position, now });
+    }
+    while (!trailHistory.empty() && (now - trailHistory.front().time > TRAIL_HISTORY || trailHistory.size() > TRAIL_MAX_HISTORY)) {
+        trailHistory.pop_front();
+    }
+
+    // Oldest first, fading in towards the current position
+    trailPoints.clear();
+    for (auto const &sample : trailHistory) {
+        trailPoints.push_back({ sample.position, static_cast<float>(1.0 - (now - sample.time) / TRAIL_HISTORY) });
+    }
+
+    // Orbits are deterministic, so the path ahead is exact rather than extrapolated
+    if (static_cast<SaunaMode>(pluginState.mode->getIndex()) == SaunaMode::Orbit) {
+        double time = displayedPlayheadTime;
+        for (int i{ 1 }; i <= TRAIL_PREDICTION_POINTS; i++) {
+            float ahead = static_cast<float>(i) / static_cast<float>(TRAIL_PREDICTION_POINTS);
+            trailPoints.push_back({ pluginState.evaluate(time + ahead * TRAIL_PREDICTION), TRAIL_PREDICTION_OPACITY * (1.0f - ahead) });
+        }
+    }
+
+    if (trailPoints.size() < 2) return;
+
+    // Two vertices per point, pushed to either side of the trail by the vertex shader
+    trailVertices.clear();
+    for (size_t i{ 0 }; i < trailPoints.size(); i++) {
+        Vec3 previous = trailPoints[i == 0 ? 0 : i - 1].first;
+        Vec3 next = trailPoints[std::min(i + 1, trailPoints.size() - 1)].first;
+
+        for (float side : { -1.0f, 1.0f }) {
+            trailVertices.push_back(GLLitVertex{
+                .position = trailPoints[i].first.toArray(),
+                .normal = packNormal(next - previous),
+                .colour = packColour(TRAIL_COLOR.withAlpha(trailPoints[i].second)),
+                .texCoord = { packHalf(0.0f), packHalf(side) }
+            });
+        }
+    }
+
+    if (auto first = trail->write(trailVertices)) {
+        glState.useProgram(*trailShader);
+        glState.drawArrays(trail->vertexArray, GL_TRIANGLE_STRIP, *first, static_cast<GLsizei>(trailVertices.size()));
+    }
 }
 
 void ViewportComponent::resized() {
     recomputeViewportSize();
+    sizeChanged = true;
+    openGLContext.triggerRepaint();
 }
 
 void ViewportComponent::shutdown() {
-	// Don't reset shaders, only buffer-holding objects
     gridFloor.reset();
-    ball.reset();
+    billboards.reset();
+    trail.reset();
 	icosphere.reset();
     postprocess.reset();
     perlin.reset();
+    profiler.reset();
+    frameUniforms.reset();
+    drawUniforms.reset();
+
+    // The last viewport out releases the shared objects while its context is still current
+    for (auto *shader : {
+        &gridFloorShader, &billboardShader, &trailShader, &icosphereShader, &downsampleShader,
+        &msaaResolveShader, &cinematicShader, &bloomDownsampleShader, &bloomBlurShader,
+        &bloomUpsampleShader
+    }) {
+        shader->reset();
+    }
+    shared.reset();
+    GLShareGroup::instance().leave(openGLContext.getRawContext());
+}
+
+// Safe from any thread, the callback always runs on the message thread
+void ViewportComponent::requestTopDown(bool automatic) {
+    if (automatic && !allowFallback) return;
+    if (topDownRequested.exchange(true)) return;
+
+    juce::MessageManager::callAsync([safe = juce::Component::SafePointer<ViewportComponent>{ this }, automatic]() {
+        if (safe && safe->onTopDownRequested) safe->onTopDownRequested(automatic);
+    });
 }
 
 void ViewportComponent::mouseMove(juce::MouseEvent const &event) {
     auto bounds = getLocalBounds().toFloat();
-    mousePosition = event.position / juce::Point<float>{ bounds.getWidth(), bounds.getHeight() };
+    pointer.post(event.position / juce::Point<float>{ bounds.getWidth(), bounds.getHeight() });
+    openGLContext.triggerRepaint();
+}
+
+void ViewportComponent::mouseDown(juce::MouseEvent const &event) {
+    if (!event.mods.isPopupMenu()) return;
+
+    auto current = antiAliasing.load();
+    auto choose{ [this](AntiAliasing mode) {
+        return [this, mode]() {
+            antiAliasing = mode;
+            sceneDirty = true;
+            openGLContext.triggerRepaint();
+        };
+    } };
+
+    juce::PopupMenu menu;
+    menu.addSectionHeader("Anti-aliasing");
+    menu.addItem("Supersampling", true, current == AntiAliasing::Supersample, choose(AntiAliasing::Supersample));
+    menu.addItem("Multisampling", multisampleSupported, current == AntiAliasing::Multisample, choose(AntiAliasing::Multisample));
+    menu.addSeparator();
+    menu.addItem("Switch to 2D view", [this]() { requestTopDown(false); });
+    menu.addItem("Show GPU profiler", timerQueriesSupported, showProfiler, [this]() {
+        showProfiler = !showProfiler.load();
+        openGLContext.triggerRepaint();
+    });
+    menu.addItem("Copy frame-time histogram", timerQueriesSupported, false, [this]() {
+        juce::SystemClipboard::copyTextToClipboard(frameTimes.report());
+    });
+    menu.showMenuAsync(juce::PopupMenu::Options{}.withTargetComponent(this).withMousePosition());
 }
 
 void ViewportComponent::mouseEnter(juce::MouseEvent const &) {
-    mouseEntered.emplace(juce::Time::getCurrentTime());
+    pointer.enteredAt = monotonicSeconds();
+    openGLContext.triggerRepaint();
 }
 
 void ViewportComponent::mouseExit(juce::MouseEvent const &) {
-    mouseEntered.reset();
-    mousePosition = INITIAL_MOUSE;
+    pointer.enteredAt = -1.0;
+    pointer.post(INITIAL_MOUSE);
+    openGLContext.triggerRepaint();
 }
\ No newline at end of file
@@ -2,242 +2,412 @@
 
 #include <JuceHeader.h>
 #include <array>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <unordered_map>
 #include <optional>
+#include <string_view>
+#include <vector>
 
 #include "util.h"
+#include "SaunaControls.h"
 
-struct SaunaControls;
-
-constexpr int RASTER_SUPERSAMPLE = 2;
-constexpr int BLOOM_PASSES = 7; // Downsampling means that higher pass counts are cheap
-constexpr int BLOOM_DOWNSAMPLE = 2;
+constexpr int RASTER_SUPERSAMPLE = 2; // Upper bound, the actual scale adapts to FRAME_BUDGET_MS
+constexpr float MIN_RASTER_SCALE = 1.0f;
+constexpr double FRAME_BUDGET_MS = 4.0; // GPU time per frame, leaving room for the host and other editors
+constexpr int BLOOM_PASSES = 7; // Levels in the bloom mip chain, the first at the viewport size and each a quarter the pixels of the last
 constexpr float BLOOM_STRENGTH = 0.125f;
+constexpr int MSAA_SAMPLES = 4; // Upper bound, limited by what the driver supports
+constexpr float ICOSPHERE_SCALE = 0.2f;
 
-struct GLVertex {
-    std::array<float, 3> position;
-    std::array<float, 3> normal;
-    std::array<float, 4> colour;
-    std::array<float, 2> texCoord;
+// How the scene raster is anti-aliased before post-processing
+enum class AntiAliasing {
+    Supersample, // Rendered at up to RASTER_SUPERSAMPLE and box-filtered down
+    Multisample // Rendered at the viewport size with MSAA_SAMPLES, then resolved
 };
 
-
+// Attribute locations `tryLoadShader` binds for every program, and the layouts that feed them
 struct GLVertexAttributes {
-    using Attribute = juce::OpenGLShaderProgram::Attribute;
-
-    // May be nullopt for a given shaderprogram if the attribute gets pruned
-    std::optional<juce::OpenGLShaderProgram::Attribute> 
-        position{},
-        normal{},
-        color{},
-        texCoord{};
-
-    GLVertexAttributes() = delete;
-    GLVertexAttributes(GLVertexAttributes const &) = delete;
-    GLVertexAttributes(GLVertexAttributes &&) noexcept = default;
-
-    GLVertexAttributes(juce::OpenGLShaderProgram const &shader) {
-        auto tryEmplace{ [&](std::optional<Attribute> &location, GLchar const *name) {
-            if (juce::gl::glGetAttribLocation(shader.getProgramID(), name) >= 0) {
-                location.emplace(shader, name);
-            } else {
-                location.reset();
-            }
-        } };
+    enum Location: GLuint {
+        POSITION = 0, NORMAL, COLOR, TEX_COORD,
+        INSTANCE_POSITION, INSTANCE_SIZE, INSTANCE_COLOR
+    };
 
-        tryEmplace(position, "aPosition");
-        tryEmplace(normal, "aNormal");
-        tryEmplace(color, "aColor");
-        tryEmplace(texCoord, "aTexCoord");
-    }
+    struct Descriptor {
+        Location location;
+        GLint size;
+        GLenum type;
+        GLboolean normalized;
+        size_t offset;
+    };
 
-    void enable() const {
-        size_t offset{ 0 };
+    // Records the layout of `Vertex` into the bound vertex array, reading from the bound GL_ARRAY_BUFFER.
+    // A non-zero divisor advances the attributes per instance rather than per vertex.
+    template <typename Vertex>
+    static void enable(GLuint divisor = 0) {
+        using namespace juce::gl;
 
-        auto vertexBuffer{ [&](std::optional<juce::OpenGLShaderProgram::Attribute> const &attrib, GLint size) {
-            if (attrib) {
-                juce::gl::glVertexAttribPointer(
-                    attrib->attributeID, size,
-                    juce::gl::GL_FLOAT, juce::gl::GL_FALSE,
-                    sizeof(GLVertex), reinterpret_cast<GLvoid *>(sizeof(float) * offset)
-                );
-                juce::gl::glEnableVertexAttribArray(attrib->attributeID);
-            }
+        for (auto const &attribute : Vertex::attributes()) {
+            glVertexAttribPointer(
+                attribute.location, attribute.size,
+                attribute.type, attribute.normalized,
+                sizeof(Vertex), reinterpret_cast<GLvoid *>(attribute.offset)
+            );
+            glEnableVertexAttribArray(attribute.location);
+            glVertexAttribDivisor(attribute.location, divisor);
+        }
+    }
+};
+
+// Round to nearest, flushing values below the smallest normal half to zero
+static inline GLushort packHalf(float value) {
+    auto bits = std::bit_cast<juce::uint32>(value);
+    auto sign = static_cast<GLushort>((bits >> 16) & 0x8000u);
+    int exponent = static_cast<int>((bits >> 23) & 0xFFu) - 127 + 15;
+    juce::uint32 mantissa = bits & 0x7FFFFFu;
+
+    if (exponent <= 0) return sign;
+    if (exponent >= 31) return static_cast<GLushort>(sign | 0x7C00u);
+
+    // A carry out of the mantissa correctly rounds up into the exponent
+    juce::uint32 half = (static_cast<juce::uint32>(exponent) << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000u) half++;
+    return static_cast<GLushort>(sign | half);
+}
+
+// Signed normalized 10-10-10-2, for GL_INT_2_10_10_10_REV. Zero vectors stay zero.
+static inline GLuint packNormal(Vec3 const &normal) {
+    float length = normal.magnitude();
+    Vec3 unit = length > 0.0f ? normal / length : Vec3{};
+
+    auto component{ [](float value, int shift) {
+        auto packed = static_cast<GLint>(std::round(std::clamp(value, -1.0f, 1.0f) * 511.0f));
+        return (static_cast<GLuint>(packed) & 0x3FFu) << shift;
+    } };
+    return component(unit.x, 0) | component(unit.y, 10) | component(unit.z, 20);
+}
+
+static inline std::array<GLubyte, 4> packColour(juce::Colour const &colour) {
+    return { colour.getRed(), colour.getGreen(), colour.getBlue(), colour.getAlpha() };
+}
+
+// Shaded surfaces and the trail, which read every per-vertex attribute
+struct GLLitVertex {
+    std::array<float, 3> position;
+    GLuint normal; // packNormal
+    std::array<GLubyte, 4> colour; // Normalized RGBA
+    std::array<GLushort, 2> texCoord; // packHalf
 
-            offset += size;
+    static constexpr auto attributes() {
+        using namespace juce::gl;
+        return std::array<GLVertexAttributes::Descriptor, 4>{ {
+            { GLVertexAttributes::POSITION, 3, GL_FLOAT, GL_FALSE, offsetof(GLLitVertex, position) },
+            { GLVertexAttributes::NORMAL, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(GLLitVertex, normal) },
+            { GLVertexAttributes::COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(GLLitVertex, colour) },
+            { GLVertexAttributes::TEX_COORD, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(GLLitVertex, texCoord) },
         } };
+    }
+};
 
-        vertexBuffer(position, 3);
-        vertexBuffer(normal, 3);
-        vertexBuffer(color, 4);
-        vertexBuffer(texCoord, 2);
+// The icosphere, whose normals and wireframe coordinates come from its geometry shader
+struct GLColorVertex {
+    std::array<float, 3> position;
+    std::array<GLubyte, 4> colour; // Normalized RGBA
+
+    static constexpr auto attributes() {
+        using namespace juce::gl;
+        return std::array<GLVertexAttributes::Descriptor, 2>{ {
+            { GLVertexAttributes::POSITION, 3, GL_FLOAT, GL_FALSE, offsetof(GLColorVertex, position) },
+            { GLVertexAttributes::COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(GLColorVertex, colour) },
+        } };
     }
+};
 
-    void disable() const {
-        auto disable{ [](std::optional<Attribute> const &attrib) {
-            if (attrib) {
-                juce::gl::glDisableVertexAttribArray(attrib->attributeID);
-            }
+// Full-screen and billboard quads. Positions fill x and y, the shaders see z = 0.
+struct GLQuadVertex {
+    std::array<float, 2> position;
+    std::array<GLushort, 2> texCoord; // packHalf
+
+    static constexpr auto attributes() {
+        using namespace juce::gl;
+        return std::array<GLVertexAttributes::Descriptor, 2>{ {
+            { GLVertexAttributes::POSITION, 2, GL_FLOAT, GL_FALSE, offsetof(GLQuadVertex, position) },
+            { GLVertexAttributes::TEX_COORD, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(GLQuadVertex, texCoord) },
         } };
+    }
+};
+
+// Per-instance data of a camera-facing quad drawn by GLBillboardBatch
+struct GLBillboardInstance {
+    std::array<float, 3> position;
+    float size; // Half the width of the quad, in world units
+    std::array<GLubyte, 4> colour; // Normalized RGBA
 
-        disable(position);
-        disable(normal);
-        disable(color);
-        disable(texCoord);
+    static constexpr auto attributes() {
+        using namespace juce::gl;
+        return std::array<GLVertexAttributes::Descriptor, 3>{ {
+            { GLVertexAttributes::INSTANCE_POSITION, 3, GL_FLOAT, GL_FALSE, offsetof(GLBillboardInstance, position) },
+            { GLVertexAttributes::INSTANCE_SIZE, 1, GL_FLOAT, GL_FALSE, offsetof(GLBillboardInstance, size) },
+            { GLVertexAttributes::INSTANCE_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(GLBillboardInstance, colour) },
+        } };
     }
 };
 
+static_assert(sizeof(GLLitVertex) == 24);
+static_assert(sizeof(GLColorVertex) == 16);
+static_assert(sizeof(GLQuadVertex) == 12);
+static_assert(sizeof(GLBillboardInstance) == 20);
 
-struct GLMeshUniforms {
-    using Uniform = juce::OpenGLShaderProgram::Uniform;
 
-    // May be nullopt for a given shaderprogram if the uniform gets pruned
-    juce::OpenGLShaderProgram::Uniform
-        modelMatrix,
-        viewMatrix,
-        projectionMatrix,
-        time,
-        texture0;
+// A std140 uniform block in a buffer of one context. Programs are shared between contexts, so
+// anything that changes from draw to draw goes through these rather than program uniforms.
+template<typename Block, GLuint Binding>
+struct GLUniformBuffer {
+    GLuint buffer{ 0 };
+
+    GLUniformBuffer() {
+        using namespace juce::gl;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    GLUniformBuffer(GLUniformBuffer const &) = delete;
+    GLUniformBuffer &operator=(GLUniformBuffer const &) = delete;
 
-    GLMeshUniforms() = delete;
-    GLMeshUniforms(GLMeshUniforms const &) = delete;
-    GLMeshUniforms(GLMeshUniforms &&) noexcept = default;
-    ~GLMeshUniforms() = default;
+    ~GLUniformBuffer() {
+        juce::gl::glDeleteBuffers(1, &buffer);
+    }
 
-    GLMeshUniforms(juce::OpenGLShaderProgram const &shader) :
-        modelMatrix{ shader, "modelMatrix" },
-        viewMatrix{ shader, "viewMatrix" },
-        projectionMatrix{ shader, "projectionMatrix" },
-		time{ shader, "time" },
-		texture0{ shader, "texture0" }
-    {}
+    // Before the draws that read it
+    void update(Block const &block) const {
+        using namespace juce::gl;
+
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &block);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, Binding, buffer);
+    }
+};
+
+struct GLFrameBlock {
+    std::array<float, 16> projectionMatrix;
+    std::array<float, 16> viewMatrix;
+    float time;
+    std::array<float, 3> padding; // std140 rounds the block up to a vec4
+};
+
+// Uniforms that change per frame rather than per object
+struct GLFrameUniforms : GLUniformBuffer<GLFrameBlock, FRAME_UNIFORMS_BINDING> {
+    using GLUniformBuffer::update;
+
+    void update(juce::Matrix3D<float> const &projectionMatrix, juce::Matrix3D<float> const &viewMatrix, float time) const {
+        update(GLFrameBlock{
+            .projectionMatrix = std::to_array(projectionMatrix.mat),
+            .viewMatrix = std::to_array(viewMatrix.mat),
+            .time = time
+        });
+    }
 };
 
+// Uniforms of each mesh object drawn
+struct GLDrawBlock {
+    std::array<float, 16> modelMatrix;
+};
+using GLDrawUniforms = GLUniformBuffer<GLDrawBlock, DRAW_UNIFORMS_BINDING>;
+
+// Uniforms of each post-processing pass. Every pass declares the whole block and reads its part.
+struct GLPassBlock {
+    std::array<float, 2> sourceScale{ 1.0f, 1.0f }; // Part of the source in use, since render targets are pooled at larger sizes
+    std::array<float, 2> direction{ 0.0f, 0.0f }; // Of the blur, in texels
+    std::array<float, 2> supersample{ 1.0f, 1.0f }; // Source pixels per output pixel of the downsample
+    std::array<float, 2> imageScale{ 1.0f, 1.0f }; // Scene and bloom parts in use in the cinematic pass
+    std::array<float, 2> bloomScale{ 1.0f, 1.0f };
+    float bloomStrength{ BLOOM_STRENGTH };
+    GLint samples{ 0 }; // Of the multisampled raster
+};
+using GLPassUniforms = GLUniformBuffer<GLPassBlock, PASS_UNIFORMS_BINDING>;
+
+static_assert(sizeof(GLFrameBlock) == 144);
+static_assert(sizeof(GLDrawBlock) == 64);
+static_assert(sizeof(GLPassBlock) == 48);
+
 
-struct FaceCollector {
+// Icosphere with shared vertices. Each level is subdivided from the one below through an
+// edge-midpoint cache, and levels are cached for the lifetime of the process.
+struct IcosphereGeometry {
     std::vector<Vec3> vertices{};
     std::vector<GLuint> indices{};
 
-    FaceCollector(FaceCollector &&other) noexcept {
-		vertices = std::move(other.vertices);
-		indices = std::move(other.indices);
-    };
-    FaceCollector() = default;
-
-	FaceCollector const &operator=(FaceCollector const &) = delete;
-	FaceCollector &operator=(FaceCollector &&) noexcept = default;
-
-    std::span<Vec3, 3> getFace(size_t face) {
-        auto offset = static_cast<size_t>(indices[face * 3]);
-        return std::span<Vec3, 3>{ vertices.begin() + offset, 3 };
-    }
-
-    void addTriangle(
-        Vec3 const &a,
-        Vec3 const &b,
-        Vec3 const &c
-    ) {
-        auto index{ static_cast<GLuint>(vertices.size()) };
-        vertices.push_back(a);
-		vertices.push_back(b);
-		vertices.push_back(c);
-        indices.push_back(index + 0);
-        indices.push_back(index + 1);
-        indices.push_back(index + 2);
-    }
-
-	std::vector<GLVertex> toVertices(juce::Colour const &color) const {
-		std::array<float, 4> colorRaw{
-			color.getFloatRed(),
-			color.getFloatGreen(),
-			color.getFloatBlue(),
-			color.getFloatAlpha()
-		};
+    static IcosphereGeometry const &level(int subdivisions) {
+        static std::mutex lock;
+        static std::deque<IcosphereGeometry> levels{}; // Deque keeps references stable as it grows
 
-		std::vector<GLVertex> result;
-		result.reserve(vertices.size());
-
-        auto faces = vertices.size() / 3;
-        for (size_t face{ 0 }; face < faces; face++) {
-            Vec3
-                a{ vertices[face * 3 + 0] },
-				b{ vertices[face * 3 + 1] },
-				c{ vertices[face * 3 + 2] },
-                normal{ (b - a).cross(c - a).normalized() };
-
-            auto vertex{ [&](Vec3 const &position, std::array<float, 2> uv) -> GLVertex {
-                return GLVertex{
-                    .position = position.toArray(),
-                    .normal = normal.toArray(),
-                    .colour = colorRaw,
-                    .texCoord = uv
-                };
-            }};
-
-            result.push_back(vertex(a, { 0.0f, 0.0f }));
-            result.push_back(vertex(b, { 1.0f, 0.0f }));
-            result.push_back(vertex(c, { 0.0f, 1.0f }));
-		}
-		return result;
-	}
+        std::scoped_lock guard{ lock };
+        if (levels.empty()) levels.push_back(icosahedron());
+        while (static_cast<int>(levels.size()) <= subdivisions) {
+            levels.push_back(levels.back().subdivided());
+        }
+        return levels[static_cast<size_t>(subdivisions)];
+    }
+
+private:
+    static IcosphereGeometry icosahedron() {
+        // http://blog.andreaskahler.com/2009/06/creating-icosphere-mesh-in-code.html
+        float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+
+        IcosphereGeometry result{
+            .vertices = {
+                Vec3{ -1,  t,  0 }, Vec3{  1,  t,  0 }, Vec3{ -1, -t,  0 }, Vec3{  1, -t,  0 },
+                Vec3{  0, -1,  t }, Vec3{  0,  1,  t }, Vec3{  0, -1, -t }, Vec3{  0,  1, -t },
+                Vec3{  t,  0, -1 }, Vec3{  t,  0,  1 }, Vec3{ -t,  0, -1 }, Vec3{ -t,  0,  1 }
+            },
+            .indices = {
+                 0, 11,  5,    0,  5,  1,    0,  1,  7,    0,  7, 10,    0, 10, 11,
+                 1,  5,  9,    5, 11,  4,   11, 10,  2,   10,  7,  6,    7,  1,  8,
+                 3,  9,  4,    3,  4,  2,    3,  2,  6,    3,  6,  8,    3,  8,  9,
+                 4,  9,  5,    2,  4, 11,    6,  2, 10,    8,  6,  7,    9,  8,  1
+            }
+        };
+
+        for (auto &vertex : result.vertices) vertex = vertex.normalized();
+        return result;
+    }
+
+    IcosphereGeometry subdivided() const {
+        IcosphereGeometry result{ .vertices = vertices };
+        result.indices.reserve(indices.size() * 4);
+
+        // Neighbouring faces share each edge, so its midpoint is only created once
+        std::unordered_map<juce::uint64, GLuint> midpoints{};
+        auto midpoint{ [&](GLuint a, GLuint b) {
+            auto key = (static_cast<juce::uint64>(std::min(a, b)) << 32) | std::max(a, b);
+            auto [found, inserted] = midpoints.try_emplace(key, static_cast<GLuint>(result.vertices.size()));
+            if (inserted) {
+                result.vertices.push_back(((vertices[a] + vertices[b]) / 2.0f).normalized());
+            }
+            return found->second;
+        } };
+
+        for (size_t face{ 0 }; face < indices.size(); face += 3) {
+            GLuint
+                a{ indices[face + 0] },
+                b{ indices[face + 1] },
+                c{ indices[face + 2] },
+                ab{ midpoint(a, b) },
+                bc{ midpoint(b, c) },
+                ca{ midpoint(c, a) };
+
+            result.indices.insert(result.indices.end(), {
+                a, ab, ca,
+                b, bc, ab,
+                c, ca, bc,
+                ab, bc, ca
+            });
+        }
+
+        return result;
+    }
 };
 
 
+// Vertex and index buffers with the layout that reads them. Buffers are shared by every
+// context in a share group, but vertex arrays aren't, so each context wraps them in its own GLMesh.
+struct GLMeshBuffers {
+    GLuint vertexBuffer{ 0 }, indexBuffer{ 0 };
+    GLsizei numIndices;
+    void (*enableAttributes)(GLuint divisor);
+
+    GLMeshBuffers(GLMeshBuffers const &) = delete;
+    GLMeshBuffers &operator=(GLMeshBuffers const &) = delete;
+
+    template <typename Vertex>
+    GLMeshBuffers(std::vector<Vertex> const &vertices, std::span<const GLuint> indices) :
+        numIndices{ static_cast<GLsizei>(indices.size()) },
+        enableAttributes{ &GLVertexAttributes::enable<Vertex> }
+    {
+        using namespace juce::gl;
+
+        // Both upload through GL_ARRAY_BUFFER, since binding GL_ELEMENT_ARRAY_BUFFER would change whatever vertex array is bound
+        glGenBuffers(1, &vertexBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertices.size() * sizeof(Vertex)), vertices.data(), GL_STATIC_DRAW);
+
+        glGenBuffers(1, &indexBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, indexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(indices.size_bytes()), indices.data(), GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        OPENGL_ASSERT();
+    }
+
+    ~GLMeshBuffers() {
+        juce::gl::glDeleteBuffers(1, &vertexBuffer);
+        juce::gl::glDeleteBuffers(1, &indexBuffer);
+    }
+};
+
 struct GLMesh {
     bool owning;
-    GLuint vertexBuffer, indexBuffer;
+    GLuint vertexArray;
     GLsizei numIndices;
+    std::shared_ptr<GLMeshBuffers const> buffers;
 
     GLMesh() = delete;
     GLMesh(GLMesh const &) = delete;
     GLMesh &operator=(GLMesh &) = delete;
 
     GLMesh(GLMesh &&other) noexcept {
-        this->~GLMesh();
-
         owning = other.owning;
-        vertexBuffer = other.vertexBuffer;
-        indexBuffer = other.indexBuffer;
+        vertexArray = other.vertexArray;
         numIndices = other.numIndices;
+        buffers = std::move(other.buffers);
 
         other.owning = false;
     }
 
-    GLMesh(std::span<const GLVertex> vertices, std::span<const GLuint> indices) :
+    // A vertex array of this context over `buffers`, which may come from another context in the share group
+    GLMesh(std::shared_ptr<GLMeshBuffers const> buffers) :
         owning{ true },
-        numIndices{ static_cast<GLsizei>(indices.size()) }
+        numIndices{ buffers->numIndices },
+        buffers{ std::move(buffers) }
     {
-        juce::gl::glGenBuffers(1, &vertexBuffer);
-        juce::gl::glBindBuffer(juce::gl::GL_ARRAY_BUFFER, vertexBuffer);
-        juce::gl::glBufferData(
-            juce::gl::GL_ARRAY_BUFFER, 
-            vertices.size_bytes(), 
-            vertices.data(), 
-            juce::gl::GL_STATIC_DRAW
-        );
-
-        juce::gl::glGenBuffers(1, &indexBuffer);
-        juce::gl::glBindBuffer(juce::gl::GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
-        juce::gl::glBufferData(
-            juce::gl::GL_ELEMENT_ARRAY_BUFFER,
-            indices.size_bytes(),
-            indices.data(),
-            juce::gl::GL_STATIC_DRAW
-        );
+        // The vertex array captures the buffers and layout, so drawing is a single bind
+        GLint previousVertexArray{ 0 };
+        juce::gl::glGetIntegerv(juce::gl::GL_VERTEX_ARRAY_BINDING, &previousVertexArray);
+        juce::gl::glGenVertexArrays(1, &vertexArray);
+        juce::gl::glBindVertexArray(vertexArray);
+
+        juce::gl::glBindBuffer(juce::gl::GL_ARRAY_BUFFER, this->buffers->vertexBuffer);
+        juce::gl::glBindBuffer(juce::gl::GL_ELEMENT_ARRAY_BUFFER, this->buffers->indexBuffer);
+        this->buffers->enableAttributes(0);
+
+        juce::gl::glBindVertexArray(static_cast<GLuint>(previousVertexArray));
+        juce::gl::glBindBuffer(juce::gl::GL_ARRAY_BUFFER, 0);
         OPENGL_ASSERT();
     }
 
+    template <typename Vertex>
+    GLMesh(std::vector<Vertex> const &vertices, std::span<const GLuint> indices) :
+        GLMesh{ std::make_shared<GLMeshBuffers const>(vertices, indices) }
+    {}
+
     ~GLMesh() {
         if (owning) {
-            juce::gl::glDeleteBuffers(1, &vertexBuffer);
-            juce::gl::glDeleteBuffers(1, &indexBuffer);
+            juce::gl::glDeleteVertexArrays(1, &vertexArray);
         }
     }
 
     GLMesh &operator=(GLMesh &&other) noexcept {
         owning = other.owning;
-        vertexBuffer = other.vertexBuffer;
-        indexBuffer = other.indexBuffer;
+        vertexArray = other.vertexArray;
         numIndices = other.numIndices;
+        buffers = std::move(other.buffers);
 
         other.owning = false;
 
@@ -247,21 +417,15 @@ struct GLMesh {
     static GLMesh quad(juce::Colour const &color) {
         constexpr float SCALE = 1.0f;
 
-        std::array<float, 4> colorRaw{
-            color.getFloatRed(),
-            color.getFloatGreen(),
-            color.getFloatBlue(),
-            color.getFloatAlpha()
-        };
-		auto vertex = [&colorRaw](std::array<float, 2> xy, std::array<float, 2> uv) {
-			return GLVertex{
+		auto vertex = [colour = packColour(color)](std::array<float, 2> xy, std::array<float, 2> uv) {
+			return GLLitVertex{
 				.position = { xy[0] * SCALE, xy[1] * SCALE, 0.0f },
-				.normal = { 0.0f, 0.0f, 1.0f },
-				.colour = colorRaw,
-				.texCoord = uv,
+				.normal = packNormal({ 0.0f, 0.0f, 1.0f }),
+				.colour = colour,
+				.texCoord = { packHalf(uv[0]), packHalf(uv[1]) },
 			};
 		};
-        std::vector<GLVertex> vertices{
+        std::vector<GLLitVertex> vertices{
             vertex({-1, -1}, {0.0, 0.0}),
 			vertex({ 1, -1}, {1.0, 0.0}),
 			vertex({-1,  1}, {0.0, 1.0}),
@@ -275,86 +439,48 @@ struct GLMesh {
         return { vertices, indices };
 	}
 
-    static GLMesh icosphere(int subdivisions, juce::Colour const &color) {
-        // http://blog.andreaskahler.com/2009/06/creating-icosphere-mesh-in-code.html
-
-        std::vector<GLVertex> vertices;
-        std::vector<GLuint> indices;
-
-        // create 12 vertices of a icosahedron
-        float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
-        auto icosphere = FaceCollector{};
-
-        std::array<Vec3, 12> planes = {
-            Vec3{ -1,  t,  0 }, // 0
-            Vec3{  1,  t,  0 }, // 1
-            Vec3{ -1, -t,  0 }, // 2
-            Vec3{  1, -t,  0 }, // 3
-
-            Vec3{  0, -1,  t }, // 4
-            Vec3{  0,  1,  t }, // 5
-            Vec3{  0, -1, -t }, // 6
-            Vec3{  0,  1, -t }, // 7
-
-            Vec3{  t,  0, -1 }, // 8
-            Vec3{  t,  0,  1 }, // 9
-            Vec3{ -t,  0, -1 }, // 10
-            Vec3{ -t,  0,  1 } // 11
+    // Unlit quad over [-1, 1], for the full-screen passes and billboards
+    static GLMesh screenQuad() {
+		auto vertex = [](std::array<float, 2> xy, std::array<float, 2> uv) {
+			return GLQuadVertex{
+				.position = xy,
+				.texCoord = { packHalf(uv[0]), packHalf(uv[1]) },
+			};
+		};
+        std::vector<GLQuadVertex> vertices{
+            vertex({-1, -1}, {0.0, 0.0}),
+			vertex({ 1, -1}, {1.0, 0.0}),
+			vertex({-1,  1}, {0.0, 1.0}),
+            vertex({ 1,  1}, {1.0, 1.0}),
+        };
+        std::vector<GLuint> indices{
+            0, 1, 2,
+            2, 1, 3
         };
 
-		std::array<int, 60> faces = {
-			 0, 11,  5,
-			 0,  5,  1,
-			 0,  1,  7,
-			 0,  7, 10,
-			 0, 10, 11,
-			 1,  5,  9,
-			 5, 11,  4,
-			11, 10,  2,
-			10,  7,  6,
-			 7,  1,  8,
-			 3,  9,  4,
-			 3,  4,  2,
-			 3,  2,  6,
-			 3,  6,  8,
-			 3,  8,  9,
-			 4,  9,  5,
-			 2,  4, 11,
-			 6,  2, 10,
-			 8,  6,  7,
-			 9,  8,  1,
-		};
+        return { vertices, indices };
+	}
 
-        for (int face{ 0 }; face < 20; face++) {
-            icosphere.addTriangle(
-                planes[faces[face * 3 + 0]].normalized(),
-                planes[faces[face * 3 + 1]].normalized(),
-                planes[faces[face * 3 + 2]].normalized()
-            );
-		}
-
-        auto subdivided = FaceCollector{};
-		for (int i{ 0 }; i < subdivisions; i++) {
-			for (size_t face{ 0 }; face < icosphere.indices.size() / 3; face += 1) {
-				auto face_ref = icosphere.getFace(face);
-				Vec3
-                    a{ face_ref[0] },
-                    b{ face_ref[1] },
-                    c{ face_ref[2] },
-                    ab{ ((a + b) / 2.0f).normalized() },
-                    bc{ ((b + c) / 2.0f).normalized() },
-                    ca{ ((c + a) / 2.0f).normalized() };
-
-				subdivided.addTriangle(a, ab, ca);
-				subdivided.addTriangle(b, bc, ab);
-				subdivided.addTriangle(c, ca, bc);
-				subdivided.addTriangle(ab, bc, ca);
-			}
-			icosphere = std::move(subdivided);
-            subdivided = FaceCollector{};
-		}
-
-		return { icosphere.toVertices(color), icosphere.indices };
+    // Face normals and the barycentric coordinates for the wireframe are
+    // rebuilt per face by icosphere.geom.glsl, so vertices only carry colour.
+    // Safe to call off the GL thread, for preparing the vertices ahead of upload.
+    static std::vector<GLColorVertex> icosphereVertices(int subdivisions, juce::Colour const &color) {
+        auto const &geometry = IcosphereGeometry::level(subdivisions);
+        auto colour = packColour(color);
+
+        std::vector<GLColorVertex> vertices;
+        vertices.reserve(geometry.vertices.size());
+        for (auto const &position : geometry.vertices) {
+            vertices.push_back(GLColorVertex{
+                .position = position.toArray(),
+                .colour = colour
+            });
+        }
+        return vertices;
+    }
+
+    static GLMesh icosphere(int subdivisions, juce::Colour const &color) {
+        return { icosphereVertices(subdivisions, color), IcosphereGeometry::level(subdivisions).indices };
     }
 
 	void drawElements() const {
@@ -365,6 +491,134 @@ struct GLMesh {
             nullptr
         );
     }
+
+	void drawElementsInstanced(GLsizei instances) const {
+        juce::gl::glDrawElementsInstanced(
+            juce::gl::GL_TRIANGLES,
+            numIndices,
+            juce::gl::GL_UNSIGNED_INT,
+            nullptr,
+            instances
+        );
+    }
+};
+
+
+// Skips GL calls that wouldn't change anything, and counts the ones that do.
+// State set outside the cache is unknown, so `beginFrame` forgets everything.
+struct GLStateCache {
+    static constexpr int MAX_TEXTURE_SLOTS = 4;
+
+    struct Counters {
+        int draws{ 0 }, stateChanges{ 0 }, skipped{ 0 };
+        size_t intermediateBytes{ 0 }; // Estimated from the texture taps of each offscreen pass and the pixels it writes
+    };
+
+    void beginFrame() {
+        program.reset();
+        vertexArray.reset();
+        activeSlot.reset();
+        textures.fill(std::nullopt);
+        blend.reset();
+        depthTest.reset();
+        depthWrite.reset();
+        counters = {};
+    }
+
+    Counters getCounters() const { return counters; }
+
+    void countTraffic(size_t bytes) {
+        counters.intermediateBytes += bytes;
+    }
+
+    void useProgram(GLProgram const &shader) {
+        if (changes(program, shader.getProgramID())) shader.use();
+    }
+
+    void bindVertexArray(GLuint array) {
+        if (changes(vertexArray, array)) juce::gl::glBindVertexArray(array);
+    }
+
+    // Leaves `slot` active either way, so callers can go on to set texture parameters
+    void bindTexture(GLuint slot, GLuint texture, GLenum target = juce::gl::GL_TEXTURE_2D) {
+        using namespace juce::gl;
+        jassert(slot < MAX_TEXTURE_SLOTS);
+
+        if (changes(activeSlot, slot)) glActiveTexture(GL_TEXTURE0 + slot);
+        if (changes(textures[slot], texture)) glBindTexture(target, texture);
+    }
+
+    // Blending is either off or additive, which is all the viewport uses
+    void setAdditiveBlend(bool enabled) {
+        using namespace juce::gl;
+
+        if (!changes(blend, enabled)) return;
+        if (enabled) {
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_ONE, GL_ONE);
+            glBlendEquation(GL_FUNC_ADD);
+        } else {
+            glDisable(GL_BLEND);
+        }
+    }
+
+    void setDepth(bool test, bool write) {
+        using namespace juce::gl;
+
+        if (changes(depthTest, test)) {
+            if (test) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
+        }
+        if (changes(depthWrite, write)) glDepthMask(write ? GL_TRUE : GL_FALSE);
+    }
+
+    void drawElements(GLMesh const &mesh) {
+        bindVertexArray(mesh.vertexArray);
+        mesh.drawElements();
+        counters.draws++;
+    }
+
+    void drawElementsInstanced(GLMesh const &mesh, GLsizei instances) {
+        bindVertexArray(mesh.vertexArray);
+        mesh.drawElementsInstanced(instances);
+        counters.draws++;
+    }
+
+    void drawArrays(GLuint array, GLenum mode, GLint first, GLsizei count) {
+        bindVertexArray(array);
+        juce::gl::glDrawArrays(mode, first, count);
+        counters.draws++;
+    }
+
+private:
+    template<typename Value>
+    bool changes(std::optional<Value> &current, Value value) {
+        if (current == value) {
+            counters.skipped++;
+            return false;
+        }
+        current = value;
+        counters.stateChanges++;
+        return true;
+    }
+
+    std::optional<GLuint> program{}, vertexArray{}, activeSlot{};
+    std::array<std::optional<GLuint>, MAX_TEXTURE_SLOTS> textures{};
+    std::optional<bool> blend{}, depthTest{}, depthWrite{};
+    Counters counters{};
+};
+
+
+// Single-channel texture with its full mip chain, built off the GL thread. Levels are box filtered
+// with wraparound to match GL_REPEAT, then stored as RGTC1 (BC4) blocks at 4 bits a texel.
+struct CompressedMipChain {
+    struct Level {
+        int width, height;
+        std::vector<juce::uint8> blocks; // 8 bytes per 4x4 block, row by row
+    };
+    std::vector<Level> levels{}; // Finest first, down to 1x1
+
+    // From the red channel of `source`
+    static CompressedMipChain fromImage(juce::Image const &source);
 };
 
 
@@ -382,28 +636,26 @@ struct GLImageTexture {
         other.owning = false;
     }
 
+    // Mip levels are generated by the driver
     GLImageTexture(juce::Image source, GLuint textureFormat) :
         textureFormat{ textureFormat }
     {
         using namespace juce::gl;
 		jassert(source.isValid());
 
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-
-        static const std::unordered_map<juce::Image::PixelFormat, GLuint> formatMap{
-            { juce::Image::ARGB, GL_RGBA },
-            { juce::Image::RGB, GL_RGB },
-            { juce::Image::SingleChannel, GL_RED }
-        };
         GLuint sourceFormat{ 0 };
-        try {
-            sourceFormat = formatMap.at(source.getFormat());
-        } catch (std::out_of_range) {
-            DBG("Unsupported source texture format: " << source.getFormat());
-            jassertfalse;
+        switch (source.getFormat()) {
+            case juce::Image::ARGB: sourceFormat = GL_RGBA; break;
+            case juce::Image::RGB: sourceFormat = GL_RGB; break;
+            case juce::Image::SingleChannel: sourceFormat = GL_RED; break;
+            default:
+                DBG("Unsupported source texture format: " << source.getFormat());
+                jassertfalse;
         }
 
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+
         DBG("Creating texture from format " << (int) sourceFormat << " with internal representation " << (int) textureFormat);
         glTexImage2D(
             GL_TEXTURE_2D, 0, textureFormat,
@@ -411,29 +663,57 @@ struct GLImageTexture {
             sourceFormat, GL_UNSIGNED_BYTE, 
             juce::Image::BitmapData{ source, juce::Image::BitmapData::ReadWriteMode::readOnly }.data
         );
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        setSampling();
     }
 
-    void bind(GLuint textureSlot) const {
+    // Uploaded as is, so there's no work for the driver beyond the copy
+    GLImageTexture(CompressedMipChain const &source) :
+        textureFormat{ juce::gl::GL_COMPRESSED_RED_RGTC1 }
+    {
         using namespace juce::gl;
-        glActiveTexture(GL_TEXTURE0 + textureSlot);
+        jassert(!source.levels.empty());
+
+        glGenTextures(1, &texture);
         glBindTexture(GL_TEXTURE_2D, texture);
+        for (size_t level{ 0 }; level < source.levels.size(); level++) {
+            auto const &data = source.levels[level];
+            glCompressedTexImage2D(
+                GL_TEXTURE_2D, static_cast<GLint>(level), textureFormat,
+                data.width, data.height, 0,
+                static_cast<GLsizei>(data.blocks.size()), data.blocks.data()
+            );
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(source.levels.size()) - 1);
+        setSampling();
+    }
+
+    void bind(GLStateCache &state, GLuint textureSlot) const {
+        state.bindTexture(textureSlot, texture);
     }
 
     ~GLImageTexture() {
         if (owning) juce::gl::glDeleteTextures(1, &texture);
     }
+
+private:
+    // Trilinear, so minified noise reads a level near its footprint instead of skipping across the base
+    static void setSampling() {
+        using namespace juce::gl;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        OPENGL_ASSERT();
+    }
 };
 
 
 struct GLMeshObject {
     GLMesh mesh;
-    std::shared_ptr<juce::OpenGLShaderProgram> shader;
-    GLVertexAttributes attribs;
-    GLMeshUniforms uniforms;
+    std::vector<GLMesh> details{}; // Optional finer levels of detail of `mesh`
+    size_t detail{ 0 }; // 0 draws `mesh`, otherwise `details[detail - 1]`
+    std::shared_ptr<GLProgram> shader;
     juce::Matrix3D<float> modelMatrix;
 	GLImageTexture const *texture0;
 
@@ -443,13 +723,11 @@ struct GLMeshObject {
 
     GLMeshObject(
         GLMesh &&handle,
-        std::shared_ptr<juce::OpenGLShaderProgram> &shader,
+        std::shared_ptr<GLProgram> &shader,
         juce::Matrix3D<float> modelMatrix = {},
 		GLImageTexture const *texture0 = nullptr
     ) noexcept : 
         mesh{ std::move(handle) },
-        attribs{ *shader },
-        uniforms{ *shader },
         shader{ shader },
         modelMatrix{ modelMatrix },
 		texture0{ texture0 }
@@ -457,8 +735,157 @@ struct GLMeshObject {
     GLMeshObject(GLMeshObject &&) noexcept = default;
     GLMeshObject &operator=(GLMeshObject &&) noexcept = default;
     ~GLMeshObject() = default;
+
+    GLMesh const &currentMesh() const {
+        return detail == 0 ? mesh : details[detail - 1];
+    }
+};
+
+// Camera-facing quads collected each frame and drawn in a single instanced call
+struct GLBillboardBatch {
+    static constexpr GLsizei INITIAL_CAPACITY = 64;
+
+    GLMesh quad;
+    std::shared_ptr<GLProgram> shader;
+    std::vector<GLBillboardInstance> instances{};
+    GLuint instanceBuffer{ 0 };
+    GLsizei capacity{ 0 };
+
+    GLBillboardBatch(GLBillboardBatch const &) = delete;
+    GLBillboardBatch &operator=(GLBillboardBatch const &) = delete;
+
+    GLBillboardBatch(std::shared_ptr<GLProgram> &shader) :
+        quad{ GLMesh::screenQuad() },
+        shader{ shader }
+    {
+        using namespace juce::gl;
+
+        glGenBuffers(1, &instanceBuffer);
+        reserve(INITIAL_CAPACITY);
+
+        // Instance attributes advance once per quad rather than once per vertex
+        GLint previousVertexArray{ 0 };
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previousVertexArray);
+        glBindVertexArray(quad.vertexArray);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        GLVertexAttributes::enable<GLBillboardInstance>(1);
+
+        glBindVertexArray(static_cast<GLuint>(previousVertexArray));
+        OPENGL_ASSERT();
+    }
+
+    ~GLBillboardBatch() {
+        juce::gl::glDeleteBuffers(1, &instanceBuffer);
+    }
+
+    void clear() {
+        instances.clear();
+    }
+
+    void add(Vec3 const &position, float size, juce::Colour const &colour) {
+        instances.push_back({
+            .position = position.toArray(),
+            .size = size,
+            .colour = packColour(colour)
+        });
+    }
+
+    // Uploads this frame's instances and draws them all at once
+    void draw(GLStateCache &state) {
+        using namespace juce::gl;
+
+        if (instances.empty()) return;
+
+        auto count = static_cast<GLsizei>(instances.size());
+        if (count > capacity) {
+            reserve(static_cast<GLsizei>(juce::nextPowerOfTwo(count)));
+        }
+
+        // Orphaning the old storage means the driver never waits on the previous frame's draw
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(GLBillboardInstance), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(GLBillboardInstance), instances.data());
+
+        state.useProgram(*shader);
+        state.drawElementsInstanced(quad, count);
+    }
+
+private:
+    void reserve(GLsizei instanceCapacity) {
+        using namespace juce::gl;
+
+        capacity = instanceCapacity;
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(GLBillboardInstance), nullptr, GL_STREAM_DRAW);
+    }
+};
+
+
+// Vertex buffer for geometry rebuilt every frame. Writes go to the unused tail of a fixed-size
+// buffer without synchronizing, and the storage is orphaned when the tail runs out, so neither
+// the CPU nor the GPU ever waits on the other and nothing is reallocated after construction.
+template <typename Vertex>
+struct GLStreamBuffer {
+    GLuint vertexArray{ 0 }, buffer{ 0 };
+    GLsizeiptr capacity, head{ 0 };
+
+    GLStreamBuffer(GLStreamBuffer const &) = delete;
+    GLStreamBuffer &operator=(GLStreamBuffer const &) = delete;
+
+    GLStreamBuffer(GLsizei maxVertices) :
+        capacity{ static_cast<GLsizeiptr>(maxVertices) * static_cast<GLsizeiptr>(sizeof(Vertex)) }
+    {
+        using namespace juce::gl;
+
+        GLint previousVertexArray{ 0 };
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previousVertexArray);
+        glGenVertexArrays(1, &vertexArray);
+        glBindVertexArray(vertexArray);
+
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+        GLVertexAttributes::enable<Vertex>();
+
+        glBindVertexArray(static_cast<GLuint>(previousVertexArray));
+        OPENGL_ASSERT();
+    }
+
+    ~GLStreamBuffer() {
+        juce::gl::glDeleteVertexArrays(1, &vertexArray);
+        juce::gl::glDeleteBuffers(1, &buffer);
+    }
+
+    // Returns the index of the first written vertex, for drawing. Spans over capacity are dropped.
+    std::optional<GLint> write(std::span<Vertex const> vertices) {
+        using namespace juce::gl;
+
+        auto bytes = static_cast<GLsizeiptr>(vertices.size_bytes());
+        if (bytes == 0 || bytes > capacity) return std::nullopt;
+
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        if (head + bytes > capacity) {
+            // Draws still reading the old storage keep it alive, this buffer gets fresh storage
+            glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+            head = 0;
+        }
+
+        void *mapped = glMapBufferRange(
+            GL_ARRAY_BUFFER, head, bytes,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT
+        );
+        if (mapped == nullptr) return std::nullopt;
+
+        std::memcpy(mapped, vertices.data(), static_cast<size_t>(bytes));
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+
+        auto first = static_cast<GLint>(head / static_cast<GLsizeiptr>(sizeof(Vertex)));
+        head += bytes;
+        return first;
+    }
 };
 
+
 struct GLBackBuffer {
     bool owning{ true };
     GLuint frameBuffer{ 0 }, outputTexture{ 0 }, depthStencilBuffer{ 0 };
@@ -490,7 +917,9 @@ struct GLBackBuffer {
         return *this;
     }
 
-    GLBackBuffer(juce::Point<int> resolution, bool useDepthStencil) : resolution{ resolution } {
+    GLBackBuffer(juce::Point<int> resolution, bool useDepthStencil, GLenum colourFormat = juce::gl::GL_R11F_G11F_B10F) :
+        resolution{ resolution }
+    {
         using namespace juce::gl;
 
         glGenFramebuffers(1, &frameBuffer);
@@ -499,7 +928,7 @@ struct GLBackBuffer {
         // Use texture for color info
         glGenTextures(1, &outputTexture);
         glBindTexture(GL_TEXTURE_2D, outputTexture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_R11F_G11F_B10F, resolution.x, resolution.y, 0, GL_RGB, GL_FLOAT, nullptr);
+        glTexImage2D(GL_TEXTURE_2D, 0, colourFormat, resolution.x, resolution.y, 0, GL_RGB, GL_FLOAT, nullptr);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -523,10 +952,8 @@ struct GLBackBuffer {
         OPENGL_ASSERT();
     }
 
-	void bindTexture(GLuint textureSlot) const {
-		using namespace juce::gl;
-		glActiveTexture(GL_TEXTURE0 + textureSlot);
-		glBindTexture(GL_TEXTURE_2D, outputTexture);
+	void bindTexture(GLStateCache &state, GLuint textureSlot) const {
+		state.bindTexture(textureSlot, outputTexture);
 	}
 
     void setRenderTarget(bool clear, juce::Point<int> bounds) const {
@@ -545,13 +972,13 @@ struct GLBackBuffer {
         setRenderTarget(clear, resolution);
     }
 
-	void blitInto(GLuint outputBuffer) const {
+	void blitInto(GLuint outputBuffer, juce::Point<int> bounds) const {
 		using namespace juce::gl;
 		glBindFramebuffer(GL_READ_FRAMEBUFFER, frameBuffer);
 		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputBuffer);
 		glBlitFramebuffer(
-			0, 0, resolution.x, resolution.y,
-			0, 0, resolution.x, resolution.y,
+			0, 0, bounds.x, bounds.y,
+			0, 0, bounds.x, bounds.y,
 			GL_COLOR_BUFFER_BIT, GL_NEAREST
 		);
 	}
@@ -568,222 +995,933 @@ struct GLBackBuffer {
 };
 
 
-struct PostProcess {
-    using Uniform = juce::OpenGLShaderProgram::Uniform;
+// Multisampled scene target. It's resolved by msaaResolve.frag.glsl rather than a blit, so the
+// samples can be weighted for HDR and a bright highlight doesn't alias the edge it crosses.
+struct GLMultisampleBuffer {
+    GLuint frameBuffer{ 0 }, colorTexture{ 0 }, depthStencilBuffer{ 0 };
+    juce::Point<int> resolution;
+    int samples;
+
+    GLMultisampleBuffer(GLMultisampleBuffer const &) = delete;
+    GLMultisampleBuffer &operator=(GLMultisampleBuffer const &) = delete;
+
+    GLMultisampleBuffer(juce::Point<int> resolution, int samples) :
+        resolution{ resolution },
+        samples{ samples }
+    {
+        using namespace juce::gl;
+
+        glGenFramebuffers(1, &frameBuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
+
+        glGenTextures(1, &colorTexture);
+        glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, colorTexture);
+        glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, GL_R11F_G11F_B10F, resolution.x, resolution.y, GL_TRUE);
+        glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, colorTexture, 0);
+
+        glGenRenderbuffers(1, &depthStencilBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthStencilBuffer);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, resolution.x, resolution.y);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthStencilBuffer);
+
+        jassert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        OPENGL_ASSERT();
+    }
+
+    ~GLMultisampleBuffer() {
+        juce::gl::glDeleteRenderbuffers(1, &depthStencilBuffer);
+        juce::gl::glDeleteTextures(1, &colorTexture);
+        juce::gl::glDeleteFramebuffers(1, &frameBuffer);
+    }
+
+    // Samples for multisampled colour, depth and stencil together, 0 without MSAA support
+    static int maxSamples() {
+        using namespace juce::gl;
+
+        GLint textureSamples{ 0 }, bufferSamples{ 0 };
+        glGetIntegerv(GL_MAX_COLOR_TEXTURE_SAMPLES, &textureSamples);
+        glGetIntegerv(GL_MAX_SAMPLES, &bufferSamples);
+        int samples = std::min({ static_cast<int>(textureSamples), static_cast<int>(bufferSamples), MSAA_SAMPLES });
+        return samples >= 2 ? samples : 0;
+    }
+
+    void bindTexture(GLStateCache &state, GLuint textureSlot) const {
+        state.bindTexture(textureSlot, colorTexture, juce::gl::GL_TEXTURE_2D_MULTISAMPLE);
+    }
+
+    void setRenderTarget(juce::Point<int> bounds) const {
+        using namespace juce::gl;
+        glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
+        glViewport(0, 0, bounds.x, bounds.y);
+    }
+};
+
+
+// Ring of GL_TIME_ELAPSED queries, read back a few frames late so the CPU never waits on the GPU
+struct GLTimerQuery {
+    static constexpr int LATENCY = 4;
+
+    std::array<GLuint, LATENCY> queries{};
+    std::array<bool, LATENCY> pending{};
+    int next{ 0 };
+    bool active{ false };
+
+    GLTimerQuery() {
+        juce::gl::glGenQueries(LATENCY, queries.data());
+    }
+    GLTimerQuery(GLTimerQuery const &) = delete;
+    GLTimerQuery &operator=(GLTimerQuery const &) = delete;
+
+    ~GLTimerQuery() {
+        juce::gl::glDeleteQueries(LATENCY, queries.data());
+    }
+
+    static bool isSupported() {
+        using namespace juce::gl;
+
+        GLint major{ 0 }, minor{ 0 };
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        return major > 3 || (major == 3 && minor >= 3) || juce::OpenGLHelpers::isExtensionSupported("GL_ARB_timer_query");
+    }
+
+    // Skips the measurement if the GPU is still behind on every query in the ring
+    void begin() {
+        if (pending[next]) return;
+
+        juce::gl::glBeginQuery(juce::gl::GL_TIME_ELAPSED, queries[next]);
+        active = true;
+    }
+
+    void end() {
+        if (!active) return;
 
+        juce::gl::glEndQuery(juce::gl::GL_TIME_ELAPSED);
+        pending[next] = true;
+        next = (next + 1) % LATENCY;
+        active = false;
+    }
+
+    // Most recent finished measurement in milliseconds, if any finished since the last call
+    std::optional<double> collect() {
+        using namespace juce::gl;
+
+        std::optional<double> result{};
+        for (int i{ 0 }; i < LATENCY; i++) {
+            int slot = (next + i) % LATENCY; // Oldest first
+            if (!pending[slot]) continue;
+
+            GLuint available{ 0 };
+            glGetQueryObjectuiv(queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) break; // Queries finish in order
+
+            GLuint64 elapsed{ 0 };
+            glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &elapsed);
+            pending[slot] = false;
+            result = static_cast<double>(elapsed) / 1.0e6;
+        }
+        return result;
+    }
+};
+
+
+// Times each pass of a frame with its own GLTimerQuery ring, so results are read back frames later
+// without stalling. Elapsed-time queries can't nest, so `begin` ends the previous pass.
+struct GLPassProfiler {
+    struct Pass {
+        std::string_view name;
+        int level; // Bloom level, or -1
+        GLTimerQuery query{};
+        double milliseconds{ 0.0 }; // Latest collected
+
+        Pass(std::string_view name, int level) : name{ name }, level{ level } {}
+
+        juce::String label() const {
+            juce::String text{ name.data(), name.size() };
+            return level >= 0 ? text + " " + juce::String{ level } : text;
+        }
+    };
+
+    GLPassProfiler() = default;
+    GLPassProfiler(GLPassProfiler const &) = delete;
+    GLPassProfiler &operator=(GLPassProfiler const &) = delete;
+
+    void beginFrame() {
+        end();
+        order.clear();
+    }
+
+    // `name` must outlive the profiler, so pass string literals
+    void begin(std::string_view name, int level = -1) {
+        end();
+
+        auto found = std::find_if(passes.begin(), passes.end(), [&](Pass const &pass) {
+            return pass.level == level && pass.name == name;
+        });
+        if (found == passes.end()) {
+            passes.emplace_back(name, level);
+            found = std::prev(passes.end());
+        }
+
+        order.push_back(static_cast<size_t>(found - passes.begin()));
+        current = &*found;
+        current->query.begin();
+    }
+
+    void end() {
+        if (!current) return;
+
+        current->query.end();
+        current = nullptr;
+    }
+
+    // Picks up finished measurements, returns whether any arrived
+    bool collect() {
+        bool updated{ false };
+        for (auto &pass : passes) {
+            if (auto time = pass.query.collect()) {
+                pass.milliseconds = *time;
+                updated = true;
+            }
+        }
+        return updated;
+    }
+
+    double milliseconds(std::string_view name) const {
+        double sum{ 0.0 };
+        for (size_t i : order) {
+            if (passes[i].name == name) sum += passes[i].milliseconds;
+        }
+        return sum;
+    }
+
+    // Over the passes of the last frame, in the order they ran
+    double total() const {
+        double sum{ 0.0 };
+        for (size_t i : order) sum += passes[i].milliseconds;
+        return sum;
+    }
+
+    std::vector<std::pair<juce::String, double>> breakdown() const {
+        std::vector<std::pair<juce::String, double>> result;
+        for (size_t i : order) result.emplace_back(passes[i].label(), passes[i].milliseconds);
+        return result;
+    }
+
+private:
+    std::deque<Pass> passes{}; // Deque, since the queries can't move
+    std::vector<size_t> order{};
+    Pass *current{ nullptr };
+};
+
+// Rolling GPU frame times for the profiler overlay and support reports. Written on the GL
+// thread and read on the message thread, so everything goes through the lock.
+struct FrameTimeHistory {
+    static constexpr size_t LENGTH = 600; // Ten seconds at 60 Hz
+    static constexpr int BUCKET_MS = 1;
+    static constexpr int BUCKETS = 16; // The last one also holds everything slower
+
+    void setRenderer(juce::String name) {
+        std::scoped_lock lock{ mutex };
+        renderer = name;
+    }
+
+    void add(double milliseconds, std::vector<std::pair<juce::String, double>> passes) {
+        std::scoped_lock lock{ mutex };
+        frames.push_back(milliseconds);
+        if (frames.size() > LENGTH) frames.pop_front();
+        lastPasses = std::move(passes);
+    }
+
+    std::vector<double> recent(size_t count) const {
+        std::scoped_lock lock{ mutex };
+        auto first = frames.size() > count ? frames.end() - static_cast<std::ptrdiff_t>(count) : frames.begin();
+        return { first, frames.end() };
+    }
+
+    std::vector<std::pair<juce::String, double>> passes() const {
+        std::scoped_lock lock{ mutex };
+        return lastPasses;
+    }
+
+    // Plain text, to paste into a support ticket
+    juce::String report() const {
+        std::scoped_lock lock{ mutex };
+
+        juce::String text;
+        text << "Viewport GPU frame times over the last " << (int) frames.size() << " frames on " << renderer << "\n";
+        if (frames.empty()) return text;
+
+        std::vector<double> sorted{ frames.begin(), frames.end() };
+        std::sort(sorted.begin(), sorted.end());
+        auto percentile{ [&](double fraction) {
+            return sorted[static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1))];
+        } };
+        text << "p50 " << juce::String(percentile(0.5), 2) << " ms, p95 " << juce::String(percentile(0.95), 2)
+             << " ms, p99 " << juce::String(percentile(0.99), 2) << " ms, max " << juce::String(sorted.back(), 2) << " ms\n";
+
+        std::array<int, BUCKETS> counts{};
+        for (double time : frames) {
+            counts[static_cast<size_t>(std::min(static_cast<int>(time) / BUCKET_MS, BUCKETS - 1))]++;
+        }
+        int largest = *std::max_element(counts.begin(), counts.end());
+        for (int i{ 0 }; i < BUCKETS; i++) {
+            auto range = juce::String{ i * BUCKET_MS } + (i == BUCKETS - 1 ? juce::String{ "+" } : "-" + juce::String{ (i + 1) * BUCKET_MS });
+            text << range.paddedLeft(' ', 6) << " ms " << juce::String::repeatedString("#", counts[i] * 40 / std::max(largest, 1)).paddedRight(' ', 40)
+                 << " " << counts[i] << "\n";
+        }
+
+        text << "Latest passes:";
+        for (auto const &[name, time] : lastPasses) {
+            text << " " << name << " " << juce::String(time, 3) << " ms,";
+        }
+        return text.trimCharactersAtEnd(",") + "\n";
+    }
+
+private:
+    mutable std::mutex mutex;
+    juce::String renderer;
+    std::deque<double> frames{};
+    std::vector<std::pair<juce::String, double>> lastPasses{};
+};
+
+
+// Scales the raster between MIN_RASTER_SCALE and RASTER_SUPERSAMPLE so frames fit FRAME_BUDGET_MS.
+// Post-processing runs at the viewport resolution, so only the scene time responds to the scale.
+struct ResolutionController {
+    static constexpr float ADJUST_RATE = 0.2f; // Fraction of the way to the target per measurement
+    static constexpr float QUANTIZE = 16.0f; // Steps per unit scale, so tiny changes don't shimmer
+
+    float scale{ static_cast<float>(RASTER_SUPERSAMPLE) };
+    double postprocessMilliseconds{ 0.0 };
+
+    void update(double sceneMilliseconds) {
+        // Scene time is roughly proportional to the pixel count, so to the square of the scale
+        double sceneBudget = std::max(FRAME_BUDGET_MS - postprocessMilliseconds, FRAME_BUDGET_MS * 0.25);
+        double ratio = std::sqrt(sceneBudget / std::max(sceneMilliseconds, 0.01));
+        float target = juce::jlimit(MIN_RASTER_SCALE, static_cast<float>(RASTER_SUPERSAMPLE), static_cast<float>(scale * ratio));
+
+        scale += (target - scale) * ADJUST_RATE;
+    }
+
+    float getScale() const {
+        return std::round(scale * QUANTIZE) / QUANTIZE;
+    }
+};
+
+
+// Texture mip pyramid with a framebuffer per level, so passes can read one level while writing another.
+// Half floats rather than GLBackBuffer's packed floats: bloom writes each level three times and
+// then sums the levels back up, and with 6 bits of mantissa the rounding adds up to a dimmer bloom.
+struct GLMipChain {
+    bool owning{ true };
+    GLuint texture{ 0 };
+    std::vector<GLuint> frameBuffers{};
+    std::vector<juce::Point<int>> resolutions{};
+
+    GLMipChain(GLMipChain const &) = delete;
+    GLMipChain &operator=(GLMipChain const &) = delete;
+    GLMipChain(GLMipChain &&other) noexcept {
+        owning = other.owning;
+        texture = other.texture;
+        frameBuffers = std::move(other.frameBuffers);
+        resolutions = std::move(other.resolutions);
+
+        other.owning = false;
+    }
+    GLMipChain &operator=(GLMipChain &&other) noexcept {
+        this->~GLMipChain();
+
+        owning = other.owning;
+        texture = other.texture;
+        frameBuffers = std::move(other.frameBuffers);
+        resolutions = std::move(other.resolutions);
+
+        other.owning = false;
+        return *this;
+    }
+
+    // Stops early once a level would be empty
+    GLMipChain(juce::Point<int> baseResolution, int maxLevels) {
+        using namespace juce::gl;
+
+        for (auto resolution{ baseResolution }; (int) resolutions.size() < maxLevels; resolution /= 2) {
+            resolutions.push_back({ std::max(resolution.x, 1), std::max(resolution.y, 1) });
+            if (resolution.x <= 1 && resolution.y <= 1) break;
+        }
+        auto levels = static_cast<GLsizei>(resolutions.size());
+
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        for (int level{ 0 }; level < levels; level++) {
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA16F, resolutions[level].x, resolutions[level].y, 0, GL_RGBA, GL_FLOAT, nullptr);
+        }
+        // Without mipmap filtering only the base level is sampled, which `bindLevel` moves around
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        frameBuffers.resize(resolutions.size());
+        glGenFramebuffers(levels, frameBuffers.data());
+        for (int level{ 0 }; level < levels; level++) {
+            glBindFramebuffer(GL_FRAMEBUFFER, frameBuffers[level]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, level);
+            jassert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        OPENGL_ASSERT();
+    }
+
+    int getLevels() const {
+        return static_cast<int>(resolutions.size());
+    }
+
+    // Every pixel inside `bounds` gets written, so there's nothing to clear
+    void setRenderTarget(int level, juce::Point<int> bounds) const {
+        using namespace juce::gl;
+        glBindFramebuffer(GL_FRAMEBUFFER, frameBuffers[level]);
+        glViewport(0, 0, bounds.x, bounds.y);
+    }
+
+    // Restricts sampling to `level`, so reading it while rendering another level isn't a feedback loop
+    void bindLevel(GLStateCache &state, GLuint textureSlot, int level) const {
+        using namespace juce::gl;
+        state.bindTexture(textureSlot, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level);
+    }
+
+    ~GLMipChain() {
+        if (owning) {
+            juce::gl::glDeleteFramebuffers(static_cast<GLsizei>(frameBuffers.size()), frameBuffers.data());
+            juce::gl::glDeleteTextures(1, &texture);
+        }
+    }
+};
+
+
+// Render targets allocated in BUCKET-pixel steps, so a resize only allocates when it crosses into
+// a new bucket. Passes render into the top-left of a target and sample it through a scale.
+// Targets no pass holds are kept for EVICT_FRAMES frames, in case a resize drag comes back to them.
+template <typename Target, typename Options>
+struct GLRenderTargetPool {
+    static constexpr int BUCKET = 128;
+    static constexpr int EVICT_FRAMES = 120;
+
+    struct Entry {
+        juce::Point<int> allocation;
+        Options options;
+        std::shared_ptr<Target> target;
+        int idleFrames;
+    };
+    std::vector<Entry> entries{};
+    int allocations{ 0 }; // Over the pool's lifetime, shown by the profiler overlay
+
+    GLRenderTargetPool() = default;
+    GLRenderTargetPool(GLRenderTargetPool const &) = delete;
+    GLRenderTargetPool &operator=(GLRenderTargetPool const &) = delete;
+    GLRenderTargetPool(GLRenderTargetPool &&) noexcept = default;
+    GLRenderTargetPool &operator=(GLRenderTargetPool &&) noexcept = default;
+
+    static juce::Point<int> bucketed(juce::Point<int> size) {
+        auto roundUp{ [](int value) { return (std::max(value, 1) + BUCKET - 1) / BUCKET * BUCKET; } };
+        return { roundUp(size.x), roundUp(size.y) };
+    }
+
+    // A target at least `size`, which stays out of the pool while the returned pointer is held
+    std::shared_ptr<Target> acquire(juce::Point<int> size, Options options) {
+        auto allocation = bucketed(size);
+        for (auto &entry : entries) {
+            if (entry.allocation == allocation && entry.options == options && entry.target.use_count() == 1) {
+                entry.idleFrames = 0;
+                return entry.target;
+            }
+        }
+
+        allocations++;
+        entries.push_back({ allocation, options, std::make_shared<Target>(allocation, options), 0 });
+        return entries.back().target;
+    }
+
+    // Once per frame, frees the targets that have been idle too long
+    void collect() {
+        for (auto &entry : entries) {
+            entry.idleFrames = entry.target.use_count() > 1 ? 0 : entry.idleFrames + 1;
+        }
+        std::erase_if(entries, [](Entry const &entry) { return entry.idleFrames > EVICT_FRAMES; });
+    }
+};
+
+
+struct PostProcess {
     GLMesh fullscreenQuad;
 
-    GLBackBuffer 
+    GLRenderTargetPool<GLBackBuffer, bool> backBuffers; // Keyed on whether they have depth and stencil
+    GLRenderTargetPool<GLMipChain, int> mipChains; // Keyed on the number of levels
+    GLRenderTargetPool<GLMultisampleBuffer, int> multisampleBuffers; // Keyed on the sample count
+
+    // Pooled, so each is usually larger than the part in use
+    std::shared_ptr<GLBackBuffer> 
         rasterBuffer, 
-        compositingBuffer, 
-        bufferA, 
-        bufferB;
+        compositingBuffer;
+
+    std::shared_ptr<GLMipChain>
+        bloomChain,
+        blurChain; // Holds each level between the two directions of its blur
+
+    // The tonemapped result of the last `process`, blitted by `present` until the scene changes.
+    // 8 bits per channel, like the presentation buffer, so redrawing it is an exact copy.
+    std::optional<GLBackBuffer> composedBuffer;
+
+    int composedAllocations{ 0 };
+
+    // Replaces rasterBuffer with AntiAliasing::Multisample
+    std::shared_ptr<GLMultisampleBuffer> multisampleBuffer;
+    AntiAliasing antiAliasing{ AntiAliasing::Supersample };
+
+    // The cinematic pass and the first bloom level read the raster directly, skipping
+    // compositingBuffer, while it isn't supersampled. See `setRasterScale`.
+    bool fuseResolve{ false };
 
-    GLVertexAttributes 
-        downsampleAttribs, 
-        cinematicAttribs, 
-        gaussianAttribs, 
-        bloomAccumulateAttribs;
+    // Bilinear taps per output pixel of each pass, for the traffic counter
+    static constexpr size_t DOWNSAMPLE_TAPS = 4;
+    static constexpr size_t BLOOM_DOWNSAMPLE_TAPS = 1;
+    static constexpr size_t BLOOM_BLUR_TAPS = 8; // In each direction
+    static constexpr size_t BLOOM_UPSAMPLE_TAPS = 1;
+    static constexpr size_t ABERRATION_SAMPLES = 5; // Of the scene and of the bloom, in the cinematic pass
 
-	std::shared_ptr<juce::OpenGLShaderProgram> 
+    static constexpr size_t PIXEL_BYTES = 4; // Packed floats or 8-bit colour, per pixel or sample
+    static constexpr size_t BLOOM_PIXEL_BYTES = 8; // Half floats, see GLMipChain
+
+	std::shared_ptr<GLProgram> 
         downsampleShader, 
+        msaaResolveShader,
         cinematicShader, 
-        gaussianShader, 
-        bloomAccumulateShader;
-
-    Uniform 
-        supersampleUniform, 
-        renderedImageUniform, 
-        downsampledImageUniform, 
-        gaussianSourceTextureUniform,
-        gaussianSourceResolutionUniform,
-        gaussianVerticalUniform,
-        bloomStrengthUniform,
-        bloomDownsampleRatioUniform,
-        bloomSourceTextureUniform;
+        bloomDownsampleShader, 
+        bloomBlurShader, 
+        bloomUpsampleShader;
+
+    GLPassUniforms passUniforms;
+
+    juce::Point<int> viewportSize; // Part of compositingBuffer in use
+    juce::Point<int> rasterBounds; // Part of rasterBuffer the scene is rendered into
 
     PostProcess(PostProcess const &) = delete;
-    PostProcess(PostProcess &&) noexcept = default;
     PostProcess &operator=(PostProcess const &) = delete;
-    PostProcess &operator=(PostProcess &&) noexcept = default;
 
     PostProcess(
-        std::shared_ptr<juce::OpenGLShaderProgram> &downsampleShader,
-        std::shared_ptr<juce::OpenGLShaderProgram> &cinematicShader,
-        std::shared_ptr<juce::OpenGLShaderProgram> &gaussianShader,
-        std::shared_ptr<juce::OpenGLShaderProgram> &bloomAccumulateShader,
+        std::shared_ptr<GLProgram> &downsampleShader,
+        std::shared_ptr<GLProgram> &msaaResolveShader,
+        std::shared_ptr<GLProgram> &cinematicShader,
+        std::shared_ptr<GLProgram> &bloomDownsampleShader,
+        std::shared_ptr<GLProgram> &bloomBlurShader,
+        std::shared_ptr<GLProgram> &bloomUpsampleShader,
         juce::Point<int> viewportSize,
         int supersample
     ) noexcept :
-        fullscreenQuad{ GLMesh::quad(juce::Colours::black) },
-        downsampleAttribs{ *downsampleShader },
-        cinematicAttribs{ *cinematicShader },
-		gaussianAttribs{ *gaussianShader },
-		bloomAccumulateAttribs{ *bloomAccumulateShader },
-
-        supersampleUniform  { *downsampleShader, "supersample" },
-        renderedImageUniform{ *downsampleShader, "renderedImage" },
-
-        downsampledImageUniform{ *cinematicShader, "downsampledImage" },
-
-		gaussianSourceTextureUniform{ *gaussianShader, "sourceTexture" },
-		gaussianSourceResolutionUniform{ *gaussianShader, "sourceResolution" },
-		gaussianVerticalUniform     { *gaussianShader, "vertical" },
-
-		bloomStrengthUniform       { *bloomAccumulateShader, "strength" },
-		bloomDownsampleRatioUniform{ *bloomAccumulateShader, "downsampleRatio" },
-		bloomSourceTextureUniform  { *bloomAccumulateShader, "sourceTexture" },
+        fullscreenQuad{ GLMesh::screenQuad() },
 
         downsampleShader{ downsampleShader },
+        msaaResolveShader{ msaaResolveShader },
         cinematicShader{ cinematicShader },
-		gaussianShader{ gaussianShader },
-		bloomAccumulateShader{ bloomAccumulateShader },
-
-        rasterBuffer{ viewportSize * supersample, true },
-        compositingBuffer{ viewportSize, false },
-		bufferA{ viewportSize, false },
-		bufferB{ viewportSize, false }
-    {}
+		bloomDownsampleShader{ bloomDownsampleShader },
+		bloomBlurShader{ bloomBlurShader },
+		bloomUpsampleShader{ bloomUpsampleShader }
+    {
+        sizeTo(viewportSize, supersample, AntiAliasing::Supersample);
+    }
 
     ~PostProcess() = default;
 
-    void sizeTo(juce::Point<int> viewportSize, int supersample) {
-        using namespace juce::gl;
+    // Buffers are sized for the largest `supersample`, so scaling below it never reallocates.
+    // Multisampling falls back to supersampling without driver support.
+    // Call once per frame. Returns whether the size or mode changed, which invalidates the last frame.
+    bool sizeTo(juce::Point<int> size, int supersample, AntiAliasing mode) {
+        backBuffers.collect();
+        mipChains.collect();
+        multisampleBuffers.collect();
+
+        int samples = mode == AntiAliasing::Multisample ? GLMultisampleBuffer::maxSamples() : 0;
+        if (samples == 0) mode = AntiAliasing::Supersample;
+
+        if (compositingBuffer && size == viewportSize && mode == antiAliasing) return false;
+
+        // Released first, so targets still in the right bucket are handed straight back
+        rasterBuffer.reset();
+        multisampleBuffer.reset();
+        compositingBuffer.reset();
+        bloomChain.reset();
+        blurChain.reset();
+
+        viewportSize = size;
+        antiAliasing = mode;
+        if (mode == AntiAliasing::Multisample) {
+            multisampleBuffer = multisampleBuffers.acquire(size, samples);
+            rasterBounds = size;
+        } else {
+            rasterBuffer = backBuffers.acquire(size * supersample, true);
+            rasterBounds = size * supersample;
+        }
+        compositingBuffer = backBuffers.acquire(size, false);
+        bloomChain = mipChains.acquire(size, BLOOM_PASSES);
+        blurChain = mipChains.acquire(size, BLOOM_PASSES);
+
+        // Only ever one per viewport, so it isn't pooled, but still bucketed to ride out resizing
+        auto composedSize = decltype(backBuffers)::bucketed(size);
+        if (!composedBuffer || composedBuffer->resolution != composedSize) {
+            composedBuffer.reset();
+            composedBuffer.emplace(composedSize, false, juce::gl::GL_RGBA8);
+            composedAllocations++;
+        }
+        setRasterScale(static_cast<float>(supersample));
+        return true;
+    }
 
-        if (rasterBuffer.resolution != viewportSize * supersample) {
-            rasterBuffer = GLBackBuffer{ viewportSize * supersample, true };
-            compositingBuffer = GLBackBuffer{ viewportSize, false };
-            bufferA = GLBackBuffer{ viewportSize, false };
-            bufferB = GLBackBuffer{ viewportSize, false };
+    // Since construction. Stops climbing once a resize drag stays within buckets it has visited.
+    int targetAllocations() const {
+        return backBuffers.allocations + mipChains.allocations + multisampleBuffers.allocations + composedAllocations;
+    }
+
+    // Binds the scene raster, whichever anti-aliasing it uses
+    void setSceneTarget() const {
+        if (multisampleBuffer) {
+            multisampleBuffer->setRenderTarget(rasterBounds);
+        } else {
+            rasterBuffer->setRenderTarget(false, rasterBounds);
         }
     }
 
-    void process(GLuint outputBuffer, bool skipVFX) const {
-        using namespace juce::gl;
+    // Only supersampling scales, multisampling always rasterizes at the viewport size
+    void setRasterScale(float scale) {
+        if (!rasterBuffer) {
+            fuseResolve = false;
+            return;
+        }
+
+        auto bounds = (viewportSize.toFloat() * scale).roundToInt();
+        rasterBounds = {
+            juce::jlimit(1, rasterBuffer->resolution.x, bounds.x),
+            juce::jlimit(1, rasterBuffer->resolution.y, bounds.y)
+        };
+
+        // The cinematic pass samples the scene five times for its aberration. Reading a supersampled
+        // raster, each sample would need DOWNSAMPLE_TAPS, 20 taps per pixel against 4 to resolve it
+        // first. Without supersampling each sample is one tap, and the resolve pass is pure overhead.
+        fuseResolve = rasterBounds.x <= viewportSize.x && rasterBounds.y <= viewportSize.y;
+    }
 
-        glBindBuffer(GL_ARRAY_BUFFER, fullscreenQuad.vertexBuffer);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, fullscreenQuad.indexBuffer);
+    static size_t pixelsIn(juce::Point<int> bounds) {
+        return static_cast<size_t>(bounds.x) * static_cast<size_t>(bounds.y);
+    }
 
-		// Downsample into compositingBuffer
-        compositingBuffer.setRenderTarget();
+    static size_t bytesIn(juce::Point<int> bounds, int samples = 1, size_t pixelBytes = PIXEL_BYTES) {
+        return pixelsIn(bounds) * pixelBytes * static_cast<size_t>(samples);
+    }
 
-        glDisable(GL_DEPTH_TEST);
-        glDisable(GL_BLEND);
+    // Read by a pass writing `bounds`, counting each bilinear tap as one texel
+    static size_t tapBytes(juce::Point<int> bounds, size_t taps, size_t pixelBytes = PIXEL_BYTES) {
+        return bytesIn(bounds, 1, pixelBytes) * taps;
+    }
 
-        downsampleShader->use();
-        if (supersampleUniform.uniformID >= 0) { supersampleUniform.set(RASTER_SUPERSAMPLE); }
-        if (renderedImageUniform.uniformID >= 0) { renderedImageUniform.set(0); } // GL_TEXTURE0
+    // Part of each bloom level in use, halving like the levels themselves
+    juce::Point<int> bloomBounds(int level) const {
+        auto bounds = viewportSize;
+        for (int i{ 0 }; i < level; i++) bounds /= 2;
+        return { std::max(bounds.x, 1), std::max(bounds.y, 1) };
+    }
 
-        downsampleAttribs.enable();
-        rasterBuffer.bindTexture(0);
-        fullscreenQuad.drawElements();
-        downsampleAttribs.disable();
+    static juce::Point<float> scaleOf(juce::Point<int> bounds, juce::Point<int> resolution) {
+        return bounds.toFloat() / resolution.toFloat();
+    }
+
+    void process(GLStateCache &state, GLuint outputBuffer, bool skipVFX, GLPassProfiler *profiler = nullptr) const {
+        state.setDepth(false, false);
+        state.setAdditiveBlend(false);
+
+        // Downsample or resolve into compositingBuffer, unless the later passes read the raster
+        if (multisampleBuffer) {
+            if (profiler) profiler->begin("Resolve");
+            compositingBuffer->setRenderTarget(false, viewportSize);
+            state.useProgram(*msaaResolveShader);
+            passUniforms.update({ .samples = multisampleBuffer->samples });
+
+            multisampleBuffer->bindTexture(state, 0);
+            state.drawElements(fullscreenQuad);
+            state.countTraffic(bytesIn(rasterBounds, multisampleBuffer->samples) + bytesIn(viewportSize));
+        } else if (!fuseResolve || skipVFX) {
+            if (profiler) profiler->begin("Downsample");
+            compositingBuffer->setRenderTarget(false, viewportSize);
+            auto supersample = rasterBounds.toFloat() / viewportSize.toFloat();
+            state.useProgram(*downsampleShader);
+            passUniforms.update({ .supersample = { supersample.x, supersample.y } });
+
+            rasterBuffer->bindTexture(state, 0);
+            state.drawElements(fullscreenQuad);
+            state.countTraffic(tapBytes(viewportSize, DOWNSAMPLE_TAPS) + bytesIn(viewportSize));
+        }
 
         if (skipVFX) {
-			compositingBuffer.blitInto(outputBuffer);
-			return;
-        }
-
-        // Bloom
-        if (compositingBuffer.resolution == bufferA.resolution) {
-			compositingBuffer.blitInto(bufferA.frameBuffer);
-        } else if (compositingBuffer.resolution / 2 == bufferA.resolution) {
-            // Downsample 2x
-            bufferA.setRenderTarget(true);
-            downsampleShader->use();
-            if (supersampleUniform.uniformID >= 0) { supersampleUniform.set(2); }
-            if (renderedImageUniform.uniformID >= 0) { renderedImageUniform.set(0); } // GL_TEXTURE0
-
-            downsampleAttribs.enable();
-            compositingBuffer.bindTexture(0);
-            fullscreenQuad.drawElements();
-            downsampleAttribs.disable();
-        } else {
-            jassertfalse; // Unhandled bloom downsampling ratio
+            if (profiler) profiler->begin("Blit");
+            compositingBuffer->blitInto(composedBuffer->frameBuffer, viewportSize);
+            state.countTraffic(2 * bytesIn(viewportSize));
+            present(state, outputBuffer, profiler);
+            return;
         }
 
-        GLBackBuffer const *vertical{ &bufferA }, *horizontal{ &bufferB };
-        juce::Point<int> bloomDownsampleBounds{ vertical->resolution };
+        auto const &scene = fuseResolve ? *rasterBuffer : *compositingBuffer;
+        auto sceneBounds = fuseResolve ? rasterBounds : viewportSize;
+
+        // Bloom, blurred with the same Gaussian at every level of the mip chain and then added back
+        // up it. Each level after the first starts as a 2x2 box of the blurred level before it.
+        int levels = bloomChain->getLevels();
+        for (int level{ 0 }; level < levels; level++) {
+            auto bounds = bloomBounds(level);
+
+            if (level > 0) {
+                if (profiler) profiler->begin("Bloom down", level);
+                bloomChain->setRenderTarget(level, bounds);
+                state.useProgram(*bloomDownsampleShader);
+                bloomChain->bindLevel(state, 0, level - 1);
+                state.drawElements(fullscreenQuad);
+                state.countTraffic(tapBytes(bounds, BLOOM_DOWNSAMPLE_TAPS, BLOOM_PIXEL_BYTES) + bytesIn(bounds, 1, BLOOM_PIXEL_BYTES));
+            }
 
-        for (int pass{ 0 }; ; ++pass) {
-            // 1. Gaussian blur X from vertical to horizontal
-            gaussianShader->use();
-            if (gaussianSourceTextureUniform.uniformID >= 0) { gaussianSourceTextureUniform.set(0); } // GL_TEXTURE0
-			if (gaussianSourceResolutionUniform.uniformID >= 0) { gaussianSourceResolutionUniform.set(bloomDownsampleBounds.toFloat().x, bloomDownsampleBounds.toFloat().y); }
-            if (gaussianVerticalUniform.uniformID >= 0) { gaussianVerticalUniform.set(0); } // Horizontally
+            // Horizontally into blurChain, the first level straight from the scene...
+            if (profiler) profiler->begin("Bloom blur", level);
+            blurChain->setRenderTarget(level, bounds);
+            state.useProgram(*bloomBlurShader);
 
-            gaussianAttribs.enable();
+            juce::Point<float> sourceScale;
+            if (level == 0) {
+                scene.bindTexture(state, 0);
+                sourceScale = scaleOf(sceneBounds, scene.resolution);
+            } else {
+                bloomChain->bindLevel(state, 0, level);
+                sourceScale = scaleOf(bounds, bloomChain->resolutions[level]);
+            }
+            passUniforms.update({ .sourceScale = { sourceScale.x, sourceScale.y }, .direction = { 1.0f, 0.0f } });
+            state.drawElements(fullscreenQuad);
+
+            // ...then vertically back
+            bloomChain->setRenderTarget(level, bounds);
+            blurChain->bindLevel(state, 0, level);
+            sourceScale = scaleOf(bounds, blurChain->resolutions[level]);
+            passUniforms.update({ .sourceScale = { sourceScale.x, sourceScale.y }, .direction = { 0.0f, 1.0f } });
+            state.drawElements(fullscreenQuad);
+            state.countTraffic(2 * (tapBytes(bounds, BLOOM_BLUR_TAPS, BLOOM_PIXEL_BYTES) + bytesIn(bounds, 1, BLOOM_PIXEL_BYTES)));
+        }
 
-            horizontal->setRenderTarget(true, bloomDownsampleBounds);
-            vertical->bindTexture(0);
-            fullscreenQuad.drawElements();
+        state.setAdditiveBlend(true);
+        state.useProgram(*bloomUpsampleShader);
+        for (int level{ levels - 1 }; level > 0; level--) {
+            if (profiler) profiler->begin("Bloom up", level - 1);
+            bloomChain->setRenderTarget(level - 1, bloomBounds(level - 1));
+            bloomChain->bindLevel(state, 0, level);
+
+            auto sourceScale = scaleOf(bloomBounds(level), bloomChain->resolutions[level]);
+            passUniforms.update({ .sourceScale = { sourceScale.x, sourceScale.y } });
+            state.drawElements(fullscreenQuad);
+            state.countTraffic(tapBytes(bloomBounds(level - 1), BLOOM_UPSAMPLE_TAPS, BLOOM_PIXEL_BYTES) + 2 * bytesIn(bloomBounds(level - 1), 1, BLOOM_PIXEL_BYTES)); // Blending reads the target too
+        }
+        state.setAdditiveBlend(false);
 
-            // 2. Gaussian blur Y from horizontal to vertical
-            if (gaussianVerticalUniform.uniformID >= 0) { gaussianVerticalUniform.set(1); } // Vertically
-            vertical->setRenderTarget(false, bloomDownsampleBounds); // Can skip clearing because downscale cleared it
-			horizontal->bindTexture(0);
-            fullscreenQuad.drawElements();
+        // Composites the scene and the bloom chain in one draw
+        if (profiler) profiler->begin("Cinematic");
+        composedBuffer->setRenderTarget(false, viewportSize);
+        state.useProgram(*cinematicShader);
 
-            gaussianAttribs.disable();
+        auto imageScale = scaleOf(sceneBounds, scene.resolution);
+        auto bloomScale = scaleOf(bloomBounds(0), bloomChain->resolutions[0]);
+        passUniforms.update({ .imageScale = { imageScale.x, imageScale.y }, .bloomScale = { bloomScale.x, bloomScale.y } });
 
-            // 3. Additive blend vertical to compositing buffer
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_ONE, GL_ONE);
-            glBlendEquation(GL_FUNC_ADD);
+        scene.bindTexture(state, 0);
+        bloomChain->bindLevel(state, 1, 0);
+        state.drawElements(fullscreenQuad);
+        state.countTraffic(tapBytes(viewportSize, ABERRATION_SAMPLES) + tapBytes(viewportSize, ABERRATION_SAMPLES, BLOOM_PIXEL_BYTES) + bytesIn(viewportSize));
 
-            // Downsample relative to vertical resolution because UV coordinates scale with texture bounds
-            juce::Point<float> downsample = vertical->resolution.toFloat() / bloomDownsampleBounds.toFloat();
-            compositingBuffer.setRenderTarget();
-            bloomAccumulateShader->use();
-            if (bloomStrengthUniform.uniformID >= 0) { bloomStrengthUniform.set(BLOOM_STRENGTH); }
-            if (bloomDownsampleRatioUniform.uniformID >= 0) { bloomDownsampleRatioUniform.set(downsample.x, downsample.y); }
-            if (bloomSourceTextureUniform.uniformID >= 0) { bloomSourceTextureUniform.set(0); } // GL_TEXTURE0
+        present(state, outputBuffer, profiler);
+    }
 
-            bloomAccumulateAttribs.enable();
-            vertical->bindTexture(0);
-            fullscreenQuad.drawElements();
-            bloomAccumulateAttribs.disable();
+    // Redraws the last processed frame into `outputBuffer`, without touching the scene
+    void present(GLStateCache &state, GLuint outputBuffer, GLPassProfiler *profiler = nullptr) const {
+        if (profiler) profiler->begin("Present");
+        composedBuffer->blitInto(outputBuffer, viewportSize);
+        state.countTraffic(bytesIn(viewportSize));
+        if (profiler) profiler->end();
+    }
+};
 
-            glDisable(GL_BLEND);
 
-            // Skip unnecessary final-pass work
-			if (pass == BLOOM_PASSES - 1) { break; }
+// CPU side of the viewport's textures and meshes, prepared on a worker so the
+// GL thread only uploads them
+struct ViewportAssets {
+    CompressedMipChain perlin;
+    std::vector<std::vector<GLColorVertex>> icosphereLevels; // Coarsest first
 
-            // 4. Downsample vertical to horizontal
-            bloomDownsampleBounds /= BLOOM_DOWNSAMPLE;
-            horizontal->setRenderTarget(true, bloomDownsampleBounds);
-			downsampleShader->use();
-			if (supersampleUniform.uniformID >= 0) { supersampleUniform.set(BLOOM_DOWNSAMPLE); }
-			if (renderedImageUniform.uniformID >= 0) { renderedImageUniform.set(0); } // GL_TEXTURE0
+    static ViewportAssets prepare();
 
-			downsampleAttribs.enable();
-			vertical->bindTexture(0);
-			fullscreenQuad.drawElements();
-			downsampleAttribs.disable();
-            
-            // 5. Swap buffers
-			std::swap(horizontal, vertical);
-		}
+    // Decoded once for every viewport that asks while the work is still referenced
+    static std::shared_ptr<std::shared_future<ViewportAssets>> request();
+};
 
+// GL objects every viewport context in the process shares: the programs, the perlin texture and the
+// static meshes' buffers. Vertex arrays, framebuffers and per-frame buffers stay with each context.
+struct ViewportSharedResources {
+    std::shared_ptr<GLProgram>
+        gridFloorShader,
+        billboardShader,
+        trailShader,
+        downsampleShader,
+        msaaResolveShader,
+        cinematicShader,
+        bloomDownsampleShader,
+        bloomBlurShader,
+        bloomUpsampleShader,
+        icosphereShader;
+    std::shared_ptr<GLMeshBuffers const> gridFloorQuad;
 
-        // Cinematic
-        glBindFramebuffer(GL_FRAMEBUFFER, outputBuffer);
-        glViewport(0, 0, compositingBuffer.resolution.x, compositingBuffer.resolution.y);
-        cinematicShader->use();
-        if (downsampledImageUniform.uniformID >= 0) { downsampledImageUniform.set(0); } // GL_TEXTURE0
+    // Linked programs come from the on-disk binary cache after the first run
+    void loadPrograms();
+
+    // Uploaded by whichever viewport first has the decoded assets
+    std::mutex assetsLock;
+    std::shared_ptr<GLImageTexture const> perlin;
+    std::vector<std::shared_ptr<GLMeshBuffers const>> icosphereLevels; // Coarsest first
+};
 
-        cinematicAttribs.enable();
-        compositingBuffer.bindTexture(0);
-        fullscreenQuad.drawElements();
-        cinematicAttribs.disable();
+// Live viewport contexts, so new ones can be created sharing objects with them. Each holds the
+// shared resources until its shutdown, so they're released with a context of the group current.
+struct GLShareGroup {
+    static GLShareGroup &instance() {
+        static GLShareGroup group;
+        return group;
     }
+
+    // A live native context for a new one to share with, or null for the first. Taken right before
+    // the new context is created, and pinned so its member stays until `join` or `unpin` releases it.
+    void *pinShareTarget() {
+        std::scoped_lock lock{ mutex };
+        for (auto &member : members) {
+            if (!member.leaving) {
+                member.pins++;
+                return member.context;
+            }
+        }
+        return nullptr;
+    }
+
+    // For a new context that was never created after all
+    void unpin(void *context) {
+        std::scoped_lock lock{ mutex };
+        release(context);
+    }
+
+    // On the GL thread of a newly created `context`, releasing the pin on `sharedWith`. Reuses its
+    // resources if the driver really shared with it, otherwise calls `create` with the new context current.
+    template <typename Create>
+    std::shared_ptr<ViewportSharedResources> join(void *context, void *sharedWith, Create &&create) {
+        std::scoped_lock lock{ mutex };
+
+        std::shared_ptr<ViewportSharedResources> resources;
+        for (auto const &member : members) {
+            if (sharedWith && member.context == sharedWith) resources = member.resources.lock();
+        }
+        release(sharedWith);
+
+        // Unshared contexts start without any programs, so a foreign name doesn't exist here
+        if (resources && !juce::gl::glIsProgram(resources->gridFloorShader->getProgramID())) {
+            resources.reset();
+        }
+        if (!resources) resources = create();
+
+        members.push_back({ context, resources });
+        return resources;
+    }
+
+    // Before `context` is destroyed. Doesn't wait for the contexts pinned to it: JUCE creates native
+    // contexts on the message thread, which is also where this one gets destroyed, so they already
+    // exist. Its member only stays, out of reach of new pins, until their joins release it.
+    void leave(void *context) {
+        std::scoped_lock lock{ mutex };
+
+        for (auto &member : members) {
+            if (member.context == context) member.leaving = true;
+        }
+        eraseLeft();
+    }
+
+private:
+    struct Member {
+        void *context;
+        std::weak_ptr<ViewportSharedResources> resources;
+        int pins{ 0 }; // New contexts being created to share with this one
+        bool leaving{ false };
+    };
+
+    void release(void *context) {
+        for (auto &member : members) {
+            if (context && member.context == context) member.pins--;
+        }
+        eraseLeft();
+    }
+
+    // The last release of a leaving member erases it
+    void eraseLeft() {
+        std::erase_if(members, [](Member const &member) { return member.leaving && member.pins == 0; });
+    }
+
+    std::mutex mutex;
+    std::vector<Member> members{};
 };
 
+// Everything a frame of the scene depends on besides the plugin state, so frames
+// can also be rendered outside the component's own loop
+struct ViewportFrame {
+    struct Marker {
+        Vec3 position;
+        float size;
+        juce::Colour colour;
+    };
+
+    juce::Matrix3D<float> projection, view, icosphereModel;
+    juce::Point<int> size; // Output pixels
+    float secondsElapsed;
+    bool trail; // Left out of reproducible frames, since it follows wall-clock time
+    std::vector<Marker> markers{}; // Drawn in the same batch as the listener
+};
+
+// Pointer state handed from the message thread to the GL thread. Each field is a single
+// lock-free atomic, so a congested message thread can never hold up a frame.
+struct PointerMailbox {
+    static_assert(std::atomic<juce::uint64>::is_always_lock_free);
+
+    std::atomic<double> enteredAt{ -1.0 }; // In seconds on the high-resolution counter, negative while outside
+
+    void post(juce::Point<float> position) {
+        packed.store(std::bit_cast<juce::uint64>(std::array<float, 2>{ position.x, position.y }));
+    }
 
-struct ViewportComponent: juce::OpenGLAppComponent {
+    juce::Point<float> position() const {
+        auto unpacked = std::bit_cast<std::array<float, 2>>(packed.load());
+        return { unpacked[0], unpacked[1] };
+    }
+
+private:
+    std::atomic<juce::uint64> packed{ 0 };
+};
+
+struct ViewportComponent: juce::OpenGLAppComponent, private juce::Timer {
     static const juce::Point<float> INITIAL_MOUSE;
     static const juce::Colour CLEAR_COLOR;
     static const double MOUSE_DELAY;
+    static const double IDLE_FRAME_INTERVAL;
 
     ViewportComponent(ViewportComponent const &) = delete;
     ViewportComponent &operator=(ViewportComponent const &) = delete;
@@ -791,8 +1929,6 @@ struct ViewportComponent: juce::OpenGLAppComponent {
     ViewportComponent(SaunaControls const& pluginState);
 	~ViewportComponent();
 
-    void update();
-
     void initialise() override;
     void recomputeViewportSize();
     void render() override;
@@ -801,38 +1937,123 @@ struct ViewportComponent: juce::OpenGLAppComponent {
     void shutdown() override;
 
     void mouseMove(juce::MouseEvent const &) override;
+    void mouseDown(juce::MouseEvent const &) override;
     void mouseEnter(juce::MouseEvent const &) override;
     void mouseExit(juce::MouseEvent const &) override;
 
+    // Called on the message thread when the 2D view should take over. `automatic` when it's
+    // because GL is a software renderer or too slow, which `allowFallback` can rule out.
+    std::function<void(bool automatic)> onTopDownRequested;
+    std::atomic<bool> allowFallback{ true };
+
 private:
 	SaunaControls const &pluginState;
-    juce::VBlankAttachment vBlankTimer;
-    juce::Time startTime;
-    juce::Time lastUpdateTime;
+    double startTime; // Seconds on the high-resolution counter
+    double lastAdvanceTime;
     float secondsElapsed;
 
-    juce::OpenGLContext openGLContext;
     juce::Rectangle<int> componentBounds, renderBounds;
 
-    std::shared_ptr<juce::OpenGLShaderProgram>
+    // Frames are rendered on request, and the scene is only redrawn when something visible changed
+    void advance();
+    void timerCallback() override;
+    double polledAudibleAt{ 0.0 }, idleRepaintTime{ 0.0 }; // Message thread only
+    std::atomic<bool> sceneDirty{ true };
+    std::atomic<bool> sizeChanged{ true };
+    Vec3 renderedPosition{};
+    double lastSceneTime{ 0.0 };
+    juce::Matrix3D<float> icosphereMatrix{};
+
+    // The source is drawn where it will be heard when the frame reaches the screen
+    Vec3 predictPosition(double scanoutTime);
+    std::deque<PositionSample> positionHistory{}; // Oldest first, as received from the audio thread
+    double framePeriod{ 1.0 / 60.0 }; // Smoothed time between frames
+
+    // Consecutive measured frames slower than the 2D fallback allows, see `render`
+    int slowFrames{ 0 };
+    std::atomic<bool> topDownRequested{ false };
+    void requestTopDown(bool automatic);
+    Vec3 displayedPosition{};
+    double displayedPlayheadTime{ 0.0 };
+
+    std::shared_ptr<GLProgram>
         gridFloorShader,
-        ballShader,
+        billboardShader,
+        trailShader,
         downsampleShader,
+        msaaResolveShader,
         cinematicShader,
-        gaussianShader,
-        bloomAccumulateShader,
+        bloomDownsampleShader,
+        bloomBlurShader,
+        bloomUpsampleShader,
         icosphereShader;
 
-    std::optional<GLImageTexture> perlin;
+    // Shared with the other open viewports, see GLShareGroup. The target stays pinned from
+    // attaching until the created context joins the group.
+    std::atomic<void *> shareTarget{ nullptr };
+    void unpinShareTarget();
+
+    // Attached only while the native context can be created at once, see `updateAttachment`
+    struct AttachmentWatcher: juce::ComponentMovementWatcher {
+        ViewportComponent &owner;
+
+        AttachmentWatcher(ViewportComponent &owner) :
+            juce::ComponentMovementWatcher{ &owner },
+            owner{ owner }
+        {}
+
+        using juce::ComponentMovementWatcher::componentMovedOrResized;
+        using juce::ComponentMovementWatcher::componentVisibilityChanged;
+        void componentMovedOrResized(bool, bool) override { owner.updateAttachment(); }
+        void componentPeerChanged() override { owner.updateAttachment(); }
+        void componentVisibilityChanged() override { owner.updateAttachment(); }
+    };
+    std::optional<AttachmentWatcher> attachmentWatcher;
+    bool attached{ false };
+    void updateAttachment();
+    std::shared_ptr<ViewportSharedResources> shared;
+    std::shared_ptr<ViewportSharedResources> createSharedResources();
+
+    // Uploaded from `assets` once the worker finishes, unless another viewport already did.
+    // A plain frame is shown until then.
+    std::shared_ptr<std::shared_future<ViewportAssets>> assets;
+    bool tryUploadAssets();
+    std::shared_ptr<GLImageTexture const> perlin;
 
     std::optional<PostProcess> postprocess;
+    std::optional<GLFrameUniforms> frameUniforms;
+    std::optional<GLDrawUniforms> drawUniforms;
+    GLStateCache glState;
+    GLStateCache::Counters sceneCounters{}; // Of the last frame that rendered the scene, for the profiler overlay
+    std::optional<GLPassProfiler> profiler; // Absent without timer query support
+    FrameTimeHistory frameTimes;
+    std::atomic<bool> showProfiler{ false }; // Toggled from the context menu
+    std::atomic<bool> timerQueriesSupported{ false };
+    void drawProfilerOverlay();
+    ResolutionController resolution;
+    std::atomic<AntiAliasing> antiAliasing{ AntiAliasing::Supersample }; // Chosen from the context menu
+    std::atomic<bool> multisampleSupported{ false };
+    std::optional<GLBillboardBatch> billboards;
+
+    static juce::Matrix3D<float> projectionFor(juce::Point<int> size);
+    static juce::Matrix3D<float> viewFor(juce::Point<float> mouse);
+    void renderScene(ViewportFrame const &frame, PostProcess &target, GLuint outputBuffer, GLPassProfiler *passProfiler);
+
+    // Renders reproducible frames through `renderScene`, see Benchmark/Main.cpp
+    friend struct ViewportBenchmark;
+
+    // Recent positions with wall-clock times in seconds, plus the predicted path ahead
+    struct TrailSample { Vec3 position; double time; };
+    std::deque<TrailSample> trailHistory{};
+    std::vector<std::pair<Vec3, float>> trailPoints{}; // Position and opacity
+    std::vector<GLLitVertex> trailVertices{};
+    std::optional<GLStreamBuffer<GLLitVertex>> trail;
+    void drawTrail();
     std::optional<GLMeshObject>
         gridFloor,
-        ball,
         icosphere;
 
-    // Relative window mouse position [-1, 1]
-    std::optional<juce::Time> mouseEntered;
-    juce::Point<float> mousePosition{ INITIAL_MOUSE };
+    // Relative window mouse position [-1, 1], posted by the mouse callbacks and eased on the GL thread
+    PointerMailbox pointer;
     juce::Point<float> smoothMouse{ INITIAL_MOUSE };
 };
\ No newline at end of file
@@ -0,0 +1,30 @@
+#version 150
+
+in vec3 aPosition;
+in vec2 aTexCoord;
+
+in vec3 aInstancePosition;
+in float aInstanceSize;
+in vec4 aInstanceColor;
+
+layout(std140) uniform FrameUniforms {
+    mat4 projectionMatrix;
+    mat4 viewMatrix;
+    float time;
+};
+
+out vec4 vColor;
+out vec2 vTexCoord;
+out vec3 vWorldPosition;
+
+void main() {
+    vColor = aInstanceColor;
+    vTexCoord = aTexCoord;
+    vWorldPosition = aInstancePosition;
+
+    // Offset the corners in view space so the quad always faces the camera
+    vec4 center = viewMatrix * vec4(aInstancePosition, 1.0);
+    vec4 corner = center + vec4(aPosition.xy * aInstanceSize, 0.0, 0.0);
+
+    gl_Position = projectionMatrix * corner;
+}
@@ -0,0 +1,55 @@
+#version 150
+
+in vec2 vTexCoord;
+
+uniform sampler2D sourceTexture;
+
+layout(std140) uniform PassUniforms {
+    vec2 sourceScale; // Part of sourceTexture in use, since render targets are pooled at larger sizes
+    vec2 direction; // Unit vector along the blur, in texels
+    vec2 supersample; // Source pixels per output pixel, between 1 and 2
+    vec2 imageScale; // Parts of each texture in the cinematic pass in use, like sourceScale
+    vec2 bloomScale;
+    float bloomStrength;
+    int samples; // Of the multisampled raster
+};
+
+out vec4 fragColor;
+
+// One axis of a radius 7 Gaussian, in 8 bilinear taps
+// https://lisyarus.github.io/blog/posts/blur-coefficients-generator.html
+const int SAMPLE_COUNT = 8;
+
+const float OFFSETS[8] = float[8](
+    -6.328357272092126,
+    -4.378621204796657,
+    -2.431625915613778,
+    -0.4862426846689484,
+    1.4588111840004858,
+    3.4048471718931532,
+    5.353083811756559,
+    7
+);
+
+const float WEIGHTS[8] = float[8](
+    0.027508406306604068,
+    0.08940648616079577,
+    0.18921490087565024,
+    0.26088633929947086,
+    0.2343989200518563,
+    0.13722534949218246,
+    0.052327012559001844,
+    0.009032585254438357
+);
+
+void main() {
+    vec2 texel = 1.0 / vec2(textureSize(sourceTexture, 0));
+
+    vec3 sum = vec3(0.0);
+    for (int i = 0; i < SAMPLE_COUNT; ++i) {
+        // Texels past the used part are left over from larger frames
+        vec2 uv = clamp(vTexCoord * sourceScale + direction * texel * OFFSETS[i], texel * 0.5, sourceScale - texel * 0.5);
+        sum += texture(sourceTexture, uv).rgb * WEIGHTS[i];
+    }
+    fragColor = vec4(sum, 1.0);
+}
@@ -0,0 +1,12 @@
+#version 150
+
+uniform sampler2D sourceTexture;
+
+out vec4 fragColor;
+
+// 2x2 box filter of the previous, twice as large level. One bilinear tap at the corner the four
+// texels share averages them exactly.
+void main() {
+    vec2 uv = gl_FragCoord.xy * 2.0 / vec2(textureSize(sourceTexture, 0));
+    fragColor = vec4(texture(sourceTexture, uv).rgb, 1.0);
+}
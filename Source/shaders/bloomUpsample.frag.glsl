@@ -0,0 +1,25 @@
+#version 150
+
+in vec2 vTexCoord;
+
+uniform sampler2D sourceTexture;
+
+layout(std140) uniform PassUniforms {
+    vec2 sourceScale; // Part of sourceTexture in use, since render targets are pooled at larger sizes
+    vec2 direction; // Unit vector along the blur, in texels
+    vec2 supersample; // Source pixels per output pixel, between 1 and 2
+    vec2 imageScale; // Parts of each texture in the cinematic pass in use, like sourceScale
+    vec2 bloomScale;
+    float bloomStrength;
+    int samples; // Of the multisampled raster
+};
+
+out vec4 fragColor;
+
+// Bilinear tap of the smaller level, added onto the next larger level of the chain
+void main() {
+    // Texels past the used part are left over from larger frames
+    vec2 texel = 1.0 / vec2(textureSize(sourceTexture, 0));
+    vec2 uv = clamp(vTexCoord * sourceScale, texel * 0.5, sourceScale - texel * 0.5);
+    fragColor = vec4(texture(sourceTexture, uv).rgb, 1.0);
+}
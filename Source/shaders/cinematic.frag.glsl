@@ -2,7 +2,18 @@
 
 in vec2 vTexCoord;
 
-uniform sampler2D downsampledImage;
+uniform sampler2D sceneImage; // Either the resolved scene or, without supersampling, the raster itself
+uniform sampler2D bloomTexture; // Top of the bloom mip chain, at a lower resolution
+
+layout(std140) uniform PassUniforms {
+    vec2 sourceScale; // Part of sourceTexture in use, since render targets are pooled at larger sizes
+    vec2 direction; // Unit vector along the blur, in texels
+    vec2 supersample; // Source pixels per output pixel, between 1 and 2
+    vec2 imageScale; // Parts of each texture in the cinematic pass in use, like sourceScale
+    vec2 bloomScale;
+    float bloomStrength;
+    int samples; // Of the multisampled raster
+};
 
 out vec4 fragColor;
 
@@ -14,11 +25,17 @@ const float DISTORTION = 0.3;
 const float VIGNETTE_STRENGTH = 0.5;
 
 // ==== UV operations ====
-float aspect_ratio(sampler2D image) {
-    vec2 resolution = vec2(textureSize(image, 0));
+float aspect_ratio(sampler2D image, vec2 scale) {
+    vec2 resolution = vec2(textureSize(image, 0)) * scale;
     return resolution.x / resolution.y;
 }
 
+// Maps a [0, 1] coordinate into the used part of `image`, clamped so filtering stays inside it
+vec2 scaled_uv(sampler2D image, vec2 uv, vec2 scale) {
+    vec2 texel = 1.0 / vec2(textureSize(image, 0));
+    return clamp(uv * scale, texel * 0.5, scale - texel * 0.5);
+}
+
 vec2 center(vec2 uv, float aspect_ratio) {
     uv *= 2.0;
     uv -= 1.0;
@@ -47,11 +64,18 @@ vec3 uncharted2(vec3 x) {
 }
 
 vec3 tonemap(vec3 color) {
-    const vec3 white = uncharted2(vec3(WHITE_LEVEL));
+    vec3 white = uncharted2(vec3(WHITE_LEVEL)); // Not const, GLSL 1.50 has no function calls in constant expressions
     return uncharted2(color * EXPOSURE) / white + LIFT;
 }
 
 
+// ==== Bloom ====
+vec3 sample_hdr(vec2 uv) {
+    return texture(sceneImage, scaled_uv(sceneImage, uv, imageScale)).rgb
+         + texture(bloomTexture, scaled_uv(bloomTexture, uv, bloomScale)).rgb * bloomStrength;
+}
+
+
 // ==== Lens effects ====
 float vignette(vec2 centered_uv) {
     float offset = 1.4;
@@ -64,7 +88,7 @@ vec3 sample_abberated(vec2 centered_uv, float aspect_ratio) {
     for (int i=0; i<5; ++i) {
         float scale = float(i) * ABBERATION * length(centered_uv);
         vec2 uv = uncenter(centered_uv * (1.0 - scale), aspect_ratio);
-        colors[i] = texture(downsampledImage, uv).rgb;
+        colors[i] = sample_hdr(uv);
     }
 
     return vec3(
@@ -76,7 +100,7 @@ vec3 sample_abberated(vec2 centered_uv, float aspect_ratio) {
 
 
 void main() {
-    float aspect_ratio = aspect_ratio(downsampledImage);
+    float aspect_ratio = aspect_ratio(sceneImage, imageScale);
     vec2 centered_uv = center(vTexCoord, aspect_ratio);
     vec3 color = sample_abberated(centered_uv, aspect_ratio);
     float vignette = vignette(centered_uv);
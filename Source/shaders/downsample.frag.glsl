@@ -1,21 +1,29 @@
 #version 150
 
 uniform sampler2D renderedImage;
-uniform int supersample;
+
+layout(std140) uniform PassUniforms {
+    vec2 sourceScale; // Part of sourceTexture in use, since render targets are pooled at larger sizes
+    vec2 direction; // Unit vector along the blur, in texels
+    vec2 supersample; // Source pixels per output pixel, between 1 and 2
+    vec2 imageScale; // Parts of each texture in the cinematic pass in use, like sourceScale
+    vec2 bloomScale;
+    float bloomStrength;
+    int samples; // Of the multisampled raster
+};
 
 out vec4 fragColor;
 
 void main() {
-    ivec2 texCoord = ivec2(gl_FragCoord.xy) * supersample;
-    vec3 color = vec3(0.0);
-    
-    for (int x = 0; x < supersample; ++x) {
-        for (int y = 0; y < supersample; ++y) {
-            color += texelFetch(renderedImage, texCoord + ivec2(x, y), 0).rgb;
-        }
-    }
-    
-    color /= float(supersample * supersample);
+    vec2 center = gl_FragCoord.xy * supersample;
+    vec2 offset = (supersample - 1.0) * 0.5;
+    vec2 texelSize = 1.0 / vec2(textureSize(renderedImage, 0));
+
+    // Four bilinear taps spanning the pixel footprint, which land on texel centers at exactly 2x
+    vec3 color = texture(renderedImage, (center + vec2(-offset.x, -offset.y)) * texelSize).rgb
+               + texture(renderedImage, (center + vec2( offset.x, -offset.y)) * texelSize).rgb
+               + texture(renderedImage, (center + vec2(-offset.x,  offset.y)) * texelSize).rgb
+               + texture(renderedImage, (center + vec2( offset.x,  offset.y)) * texelSize).rgb;
 
-    fragColor = vec4(color, 1.0);
-}
\ No newline at end of file
+    fragColor = vec4(color * 0.25, 1.0);
+}
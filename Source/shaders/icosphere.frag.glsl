@@ -7,7 +7,12 @@ in vec3 vWorldPosition;
 in vec3 vPosition;
 
 uniform sampler2D texture0;
-uniform float time;
+
+layout(std140) uniform FrameUniforms {
+    mat4 projectionMatrix;
+    mat4 viewMatrix;
+    float time;
+};
 
 out vec4 fragColor;
 
@@ -0,0 +1,50 @@
+#version 150
+
+// Vertices are shared between faces, so the flat normal and the barycentric
+// coordinates for the wireframe are rebuilt per face here.
+
+layout(triangles) in;
+layout(triangle_strip, max_vertices = 3) out;
+
+in vec4 gColor[];
+in vec3 gWorldPosition[];
+in vec3 gPosition[];
+
+layout(std140) uniform FrameUniforms {
+    mat4 projectionMatrix;
+    mat4 viewMatrix;
+    float time;
+};
+
+layout(std140) uniform DrawUniforms {
+    mat4 modelMatrix;
+};
+
+out vec4 vColor;
+out vec2 vTexCoord;
+out vec3 vWorldPosition;
+out vec3 vPosition;
+out float vScreenFacing;
+
+const vec2 BARYCENTRIC[3] = vec2[3](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(0.0, 1.0));
+
+void main() {
+    vec3 worldNormal = normalize(cross(
+        gWorldPosition[1] - gWorldPosition[0],
+        gWorldPosition[2] - gWorldPosition[0]
+    ));
+    vec3 viewSpaceNormal = normalize(mat3(viewMatrix) * worldNormal);
+    float screenFacing = dot(normalize((viewMatrix * modelMatrix)[3].xyz), -viewSpaceNormal);
+
+    for (int i = 0; i < 3; i++) {
+        vColor = gColor[i];
+        vTexCoord = BARYCENTRIC[i];
+        vWorldPosition = gWorldPosition[i];
+        vPosition = gPosition[i];
+        vScreenFacing = screenFacing;
+
+        gl_Position = gl_in[i].gl_Position;
+        EmitVertex();
+    }
+    EndPrimitive();
+}
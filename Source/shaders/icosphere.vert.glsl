@@ -0,0 +1,26 @@
+#version 150
+
+in vec3 aPosition;
+in vec4 aColor;
+
+layout(std140) uniform FrameUniforms {
+    mat4 projectionMatrix;
+    mat4 viewMatrix;
+    float time;
+};
+
+layout(std140) uniform DrawUniforms {
+    mat4 modelMatrix;
+};
+
+out vec4 gColor;
+out vec3 gWorldPosition;
+out vec3 gPosition;
+
+void main() {
+    gColor = aColor;
+    gPosition = aPosition;
+    gWorldPosition = (modelMatrix * vec4(aPosition, 1.0)).xyz;
+
+    gl_Position = projectionMatrix * viewMatrix * vec4(gWorldPosition, 1.0);
+}
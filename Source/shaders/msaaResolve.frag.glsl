@@ -0,0 +1,34 @@
+#version 150
+
+uniform sampler2DMS renderedImage;
+
+layout(std140) uniform PassUniforms {
+    vec2 sourceScale; // Part of sourceTexture in use, since render targets are pooled at larger sizes
+    vec2 direction; // Unit vector along the blur, in texels
+    vec2 supersample; // Source pixels per output pixel, between 1 and 2
+    vec2 imageScale; // Parts of each texture in the cinematic pass in use, like sourceScale
+    vec2 bloomScale;
+    float bloomStrength;
+    int samples; // Of the multisampled raster
+};
+
+out vec4 fragColor;
+
+// Weighting each sample by 1 / (1 + luma) averages in a compressed range, so one very
+// bright sample can't outweigh the rest of an edge pixel and bring back the aliasing
+// https://graphicrants.blogspot.com/2013/12/tone-mapping.html
+void main() {
+    ivec2 coord = ivec2(gl_FragCoord.xy);
+
+    vec3 color = vec3(0.0);
+    float weights = 0.0;
+    for (int i = 0; i < samples; i++) {
+        vec3 sampled = texelFetch(renderedImage, coord, i).rgb;
+        float weight = 1.0 / (1.0 + dot(sampled, vec3(0.2126, 0.7152, 0.0722)));
+
+        color += sampled * weight;
+        weights += weight;
+    }
+
+    fragColor = vec4(color / weights, 1.0);
+}
@@ -5,9 +5,15 @@ in vec3 aNormal;
 in vec4 aColor;
 in vec2 aTexCoord;
 
-uniform mat4 projectionMatrix;
-uniform mat4 viewMatrix;
-uniform mat4 modelMatrix;
+layout(std140) uniform FrameUniforms {
+    mat4 projectionMatrix;
+    mat4 viewMatrix;
+    float time;
+};
+
+layout(std140) uniform DrawUniforms {
+    mat4 modelMatrix;
+};
 
 out vec4 vColor;
 out vec2 vTexCoord;
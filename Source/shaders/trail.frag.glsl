@@ -0,0 +1,14 @@
+#version 150
+
+in vec4 vColor;
+in float vSide;
+
+out vec4 fragColor;
+
+const float BRIGHTNESS = 4.0;
+
+void main() {
+    // Bright core fading towards the edges, which bloom spreads into a glow
+    float glow = exp(-4.0 * vSide * vSide);
+    fragColor = vec4(vColor.rgb * vColor.a * glow * BRIGHTNESS, 1.0);
+}
@@ -0,0 +1,31 @@
+#version 150
+
+in vec3 aPosition;
+in vec3 aNormal; // Direction along the trail
+in vec4 aColor;
+in vec2 aTexCoord; // y is the side of the ribbon, -1 or 1
+
+layout(std140) uniform FrameUniforms {
+    mat4 projectionMatrix;
+    mat4 viewMatrix;
+    float time;
+};
+
+out vec4 vColor;
+out float vSide;
+
+const float HALF_WIDTH = 0.02;
+
+void main() {
+    vColor = aColor;
+    vSide = aTexCoord.y;
+
+    // Widen perpendicular to the trail in view space, so the ribbon always faces the camera
+    vec4 center = viewMatrix * vec4(aPosition, 1.0);
+    vec3 tangent = mat3(viewMatrix) * aNormal;
+    vec2 across = vec2(tangent.y, -tangent.x);
+    float acrossLength = length(across);
+    across = acrossLength > 1e-6 ? across / acrossLength : vec2(0.0);
+
+    gl_Position = projectionMatrix * (center + vec4(across * HALF_WIDTH * aTexCoord.y, 0.0, 0.0));
+}
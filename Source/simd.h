@@ -0,0 +1,96 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+ #define SAUNA_SIMD_SSE 1
+#elif JUCE_ARM && (defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64))
+ #include <arm_neon.h>
+ #define SAUNA_SIMD_NEON 1
+ #if defined(__aarch64__) || defined(_M_ARM64)
+  #define SAUNA_SIMD_NEON_DOUBLE 1 // Double-precision lanes are AArch64 only
+ #endif
+#endif
+
+// Kernels that juce::FloatVectorOperations doesn't provide
+namespace simd {
+
+// Two accumulators hide the add latency; the tail is summed scalar
+static inline float dotProduct(float const *a, float const *b, int count) {
+    int i{ 0 };
+    float sum{ 0.0f };
+
+#if SAUNA_SIMD_SSE
+    __m128 accumulator0 = _mm_setzero_ps(), accumulator1 = _mm_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        accumulator0 = _mm_add_ps(accumulator0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        accumulator1 = _mm_add_ps(accumulator1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, _mm_add_ps(accumulator0, accumulator1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif SAUNA_SIMD_NEON
+    float32x4_t accumulator0 = vdupq_n_f32(0.0f), accumulator1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= count; i += 8) {
+        accumulator0 = vmlaq_f32(accumulator0, vld1q_f32(a + i), vld1q_f32(b + i));
+        accumulator1 = vmlaq_f32(accumulator1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+
+    float32x4_t accumulator = vaddq_f32(accumulator0, accumulator1);
+    float32x2_t pair = vadd_f32(vget_low_f32(accumulator), vget_high_f32(accumulator));
+    sum = vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+
+    for (; i < count; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+static inline void convert(float *destination, double const *source, int count) {
+    int i{ 0 };
+
+#if SAUNA_SIMD_SSE
+    for (; i + 4 <= count; i += 4) {
+        __m128 low = _mm_cvtpd_ps(_mm_loadu_pd(source + i));
+        __m128 high = _mm_cvtpd_ps(_mm_loadu_pd(source + i + 2));
+        _mm_storeu_ps(destination + i, _mm_movelh_ps(low, high));
+    }
+#elif SAUNA_SIMD_NEON_DOUBLE
+    for (; i + 4 <= count; i += 4) {
+        float32x2_t low = vcvt_f32_f64(vld1q_f64(source + i));
+        float32x2_t high = vcvt_f32_f64(vld1q_f64(source + i + 2));
+        vst1q_f32(destination + i, vcombine_f32(low, high));
+    }
+#endif
+
+    for (; i < count; i++) {
+        destination[i] = static_cast<float>(source[i]);
+    }
+}
+
+static inline void convert(double *destination, float const *source, int count) {
+    int i{ 0 };
+
+#if SAUNA_SIMD_SSE
+    for (; i + 4 <= count; i += 4) {
+        __m128 value = _mm_loadu_ps(source + i);
+        _mm_storeu_pd(destination + i, _mm_cvtps_pd(value));
+        _mm_storeu_pd(destination + i + 2, _mm_cvtps_pd(_mm_movehl_ps(value, value)));
+    }
+#elif SAUNA_SIMD_NEON_DOUBLE
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t value = vld1q_f32(source + i);
+        vst1q_f64(destination + i, vcvt_f64_f32(vget_low_f32(value)));
+        vst1q_f64(destination + i + 2, vcvt_high_f64_f32(value));
+    }
+#endif
+
+    for (; i < count; i++) {
+        destination[i] = static_cast<double>(source[i]);
+    }
+}
+
+}
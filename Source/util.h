@@ -1,6 +1,8 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <cstring>
 #include <span>
 #include <format>
 #include <JuceHeader.h>
@@ -129,6 +131,63 @@ struct Vec3 {
     }
 };
 
+// Process-wide clock for timestamps that cross threads
+static inline double monotonicSeconds() {
+    return juce::Time::getMillisecondCounterHiRes() / 1000.0;
+}
+
+// Hands a value from one writer thread to any number of readers. The writer never waits, readers
+// retry while a store is in flight. Every field is copied as lock-free words, so unlike a large
+// std::atomic there's no hidden mutex for the audio thread to block on.
+template<typename T>
+struct SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(std::atomic<juce::uint64>::is_always_lock_free);
+
+    SeqLock(T const &value = {}) { store(value); }
+    SeqLock(SeqLock const &) = delete;
+    SeqLock &operator=(SeqLock const &) = delete;
+
+    // From the single writer only
+    void store(T const &value) {
+        Words words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        auto version = sequence.load(std::memory_order_relaxed);
+        sequence.store(version + 1, std::memory_order_relaxed); // Odd while writing
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i{ 0 }; i < WORDS; i++) {
+            data[i].store(words[i], std::memory_order_relaxed);
+        }
+        sequence.store(version + 2, std::memory_order_release);
+    }
+
+    T load() const {
+        Words words{};
+        while (true) {
+            auto version = sequence.load(std::memory_order_acquire);
+            if (version & 1) continue;
+
+            for (size_t i{ 0 }; i < WORDS; i++) {
+                words[i] = data[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == version) break;
+        }
+
+        T value;
+        std::memcpy(&value, words.data(), sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(juce::uint64) - 1) / sizeof(juce::uint64);
+    using Words = std::array<juce::uint64, WORDS>;
+
+    std::atomic<juce::uint64> sequence{ 0 };
+    std::array<std::atomic<juce::uint64>, WORDS> data{};
+};
+
 template<typename T>
 static inline juce::Matrix3D<T> rotationTranslationScale(
 	Vec3 rotation,
@@ -204,29 +263,238 @@ static inline Data expEase(Data const &current, Data const &target, float easing
     return target + (current - target) * std::exp(-easing * delta);
 }
 
+// Every program binds its vertex attributes to these locations, so one vertex array fits them all
+constexpr std::array<char const *, 7> VERTEX_ATTRIBUTE_NAMES{
+    "aPosition", "aNormal", "aColor", "aTexCoord",
+    "aInstancePosition", "aInstanceSize", "aInstanceColor"
+};
+// Uniform buffer bindings of the std140 blocks, which `tryLoadShader` points each program's blocks at
+constexpr GLuint FRAME_UNIFORMS_BINDING = 0;
+constexpr GLuint DRAW_UNIFORMS_BINDING = 1;
+constexpr GLuint PASS_UNIFORMS_BINDING = 2;
+constexpr std::array<char const *, 3> UNIFORM_BLOCK_NAMES{ "FrameUniforms", "DrawUniforms", "PassUniforms" }; // By binding
+
+// Linked programs are cached on disk, keyed by their sources and the driver that linked them
+static bool programBinariesSupported() {
+    using namespace juce::gl;
+
+    if (glGetProgramBinary == nullptr || glProgramBinary == nullptr) return false;
+
+    GLint formats{ 0 };
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+// Per-user folder for the files the plugin writes itself
+static juce::File pluginDataDirectory() {
+#if JUCE_MAC
+    auto directory = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("Application Support");
+#else
+    auto directory = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory);
+#endif
+    return directory.getChildFile(JucePlugin_Name);
+}
+
+static juce::File programBinaryFile(std::initializer_list<char const *> sources) {
+    using namespace juce::gl;
+
+    juce::String key;
+    for (auto *source : sources) {
+        key << (source ? source : "") << "\n//\n";
+    }
+    for (auto *name : VERTEX_ATTRIBUTE_NAMES) {
+        key << name << "\n";
+    }
+    for (auto parameter : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+        key << reinterpret_cast<char const *>(glGetString(parameter)) << "\n";
+    }
+
+    return pluginDataDirectory()
+        .getChildFile("ProgramCache")
+        .getChildFile(juce::String::toHexString(key.hashCode64()) + ".bin");
+}
+
+// A linked program. Unlike juce::OpenGLShaderProgram it doesn't keep the context that created it,
+// so every context of a share group can use it and whichever is current last can delete it.
+struct GLProgram {
+    // -1 if the program doesn't use it, in which case setting it does nothing
+    struct Uniform {
+        GLint uniformID;
+
+        Uniform(GLProgram const &program, char const *name) :
+            uniformID{ juce::gl::glGetUniformLocation(program.getProgramID(), name) }
+        {}
+
+        void set(GLint value) const { juce::gl::glUniform1i(uniformID, value); }
+        void set(GLfloat value) const { juce::gl::glUniform1f(uniformID, value); }
+        void set(GLfloat x, GLfloat y) const { juce::gl::glUniform2f(uniformID, x, y); }
+        void setMatrix4(GLfloat const *values, GLint count, GLboolean transpose) const {
+            juce::gl::glUniformMatrix4fv(uniformID, count, transpose, values);
+        }
+    };
+
+    GLProgram() : programID{ juce::gl::glCreateProgram() } {}
+    GLProgram(GLProgram const &) = delete;
+    GLProgram &operator=(GLProgram const &) = delete;
+    ~GLProgram() { juce::gl::glDeleteProgram(programID); }
+
+    GLuint getProgramID() const { return programID; }
+    void use() const { juce::gl::glUseProgram(programID); }
+    juce::String const &getLastError() const { return lastError; }
+
+    bool addShader(char const *source, GLenum type) {
+        using namespace juce::gl;
+
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+
+        GLint compiled{ GL_FALSE };
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if (compiled == GL_TRUE) {
+            glAttachShader(programID, shader);
+        } else {
+            lastError = logOf(shader, glGetShaderInfoLog);
+        }
+
+        // Attached shaders are only flagged, and go once the program is deleted
+        glDeleteShader(shader);
+        return compiled == GL_TRUE;
+    }
+
+    bool link() {
+        using namespace juce::gl;
+
+        glLinkProgram(programID);
+
+        GLint linked{ GL_FALSE };
+        glGetProgramiv(programID, GL_LINK_STATUS, &linked);
+        if (linked != GL_TRUE) lastError = logOf(programID, glGetProgramInfoLog);
+        return linked == GL_TRUE;
+    }
+
+private:
+    GLuint programID;
+    juce::String lastError;
+
+    template <typename GetLog>
+    static juce::String logOf(GLuint object, GetLog getLog) {
+        std::array<char, 4096> log{};
+        GLsizei length{ 0 };
+        getLog(object, static_cast<GLsizei>(log.size()), &length, log.data());
+        return juce::String{ log.data(), static_cast<size_t>(length) };
+    }
+};
+
+// Binaries stop linking when the driver changes in a way its version string doesn't show
+static bool tryLoadProgramBinary(GLProgram &shader, juce::File const &file) {
+    using namespace juce::gl;
+
+    juce::MemoryBlock data;
+    if (!file.loadFileAsData(data) || data.getSize() <= sizeof(GLenum)) return false;
+
+    GLenum format;
+    std::memcpy(&format, data.getData(), sizeof(GLenum));
+    glProgramBinary(
+        shader.getProgramID(), format,
+        static_cast<char const *>(data.getData()) + sizeof(GLenum),
+        static_cast<GLsizei>(data.getSize() - sizeof(GLenum))
+    );
+
+    GLint linked{ GL_FALSE };
+    glGetProgramiv(shader.getProgramID(), GL_LINK_STATUS, &linked);
+    return linked == GL_TRUE;
+}
+
+static void saveProgramBinary(GLProgram &shader, juce::File const &file) {
+    using namespace juce::gl;
+
+    GLint length{ 0 };
+    glGetProgramiv(shader.getProgramID(), GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    // The binary format comes first, followed by the binary itself
+    juce::MemoryBlock data{ sizeof(GLenum) + static_cast<size_t>(length) };
+    GLenum format{ 0 };
+    GLsizei written{ 0 };
+    glGetProgramBinary(shader.getProgramID(), length, &written, &format, static_cast<char *>(data.getData()) + sizeof(GLenum));
+    if (written <= 0) return;
+
+    std::memcpy(data.getData(), &format, sizeof(GLenum));
+    data.setSize(sizeof(GLenum) + static_cast<size_t>(written));
+
+    // Other instances may be writing the same program, so the file is replaced in one move
+    file.getParentDirectory().createDirectory();
+    juce::TemporaryFile temporary{ file };
+    if (temporary.getFile().replaceWithData(data.getData(), data.getSize())) {
+        temporary.overwriteTargetFileWithTemporary();
+    }
+}
+
 static bool tryLoadShader(
-	std::shared_ptr<juce::OpenGLShaderProgram> &shader,
-    juce::OpenGLContext &context,
+	std::shared_ptr<GLProgram> &shader,
     char const *vertexSource,
     char const *fragmentSource,
-    char const *shaderName
+    char const *shaderName,
+    char const *geometrySource = nullptr
 ) {
     if (shader) return false;
     
-    shader = std::make_shared<juce::OpenGLShaderProgram>(context);
+    shader = std::make_shared<GLProgram>();
 
-    if (!shader->addVertexShader(vertexSource)) {
-        DBG("\n\nVertex Shader Error in " << shaderName << ":\n" << shader->getLastError().toStdString());
-        jassertfalse;
-    }
-    if (!shader->addFragmentShader(fragmentSource)) {
-        DBG("\n\nFragment Shader Error in " << shaderName << ":\n" << shader->getLastError().toStdString());
-        jassertfalse;
+    bool cacheable = programBinariesSupported();
+    auto cacheFile = cacheable ? programBinaryFile({ vertexSource, fragmentSource, geometrySource }) : juce::File{};
+
+    // Attribute locations are part of the linked binary, so only the block bindings are redone below
+    if (!cacheable || !tryLoadProgramBinary(*shader, cacheFile)) {
+        if (!shader->addShader(vertexSource, juce::gl::GL_VERTEX_SHADER)) {
+            DBG("\n\nVertex Shader Error in " << shaderName << ":\n" << shader->getLastError().toStdString());
+            jassertfalse;
+        }
+        if (!shader->addShader(fragmentSource, juce::gl::GL_FRAGMENT_SHADER)) {
+            DBG("\n\nFragment Shader Error in " << shaderName << ":\n" << shader->getLastError().toStdString());
+            jassertfalse;
+        }
+        if (geometrySource && !shader->addShader(geometrySource, juce::gl::GL_GEOMETRY_SHADER)) {
+            DBG("\n\nGeometry Shader Error in " << shaderName << ":\n" << shader->getLastError().toStdString());
+            jassertfalse;
+        }
+
+        for (GLuint location{ 0 }; location < VERTEX_ATTRIBUTE_NAMES.size(); location++) {
+            juce::gl::glBindAttribLocation(shader->getProgramID(), location, VERTEX_ATTRIBUTE_NAMES[location]);
+        }
+
+        if (cacheable) {
+            juce::gl::glProgramParameteri(shader->getProgramID(), juce::gl::GL_PROGRAM_BINARY_RETRIEVABLE_HINT, juce::gl::GL_TRUE);
+        }
+
+        if (!shader->link()) {
+            DBG("\n\nShader Link Error in " << shaderName << ":\n" << shader->getLastError().toStdString());
+            jassertfalse;
+        } else if (cacheable) {
+            saveProgramBinary(*shader, cacheFile);
+        }
     }
-    if (!shader->link()) {
-        DBG("\n\nShader Link Error in " << shaderName << ":\n" << shader->getLastError().toStdString());
-        jassertfalse;
+
+    for (GLuint binding{ 0 }; binding < UNIFORM_BLOCK_NAMES.size(); binding++) {
+        GLuint block = juce::gl::glGetUniformBlockIndex(shader->getProgramID(), UNIFORM_BLOCK_NAMES[binding]);
+        if (block != juce::gl::GL_INVALID_INDEX) {
+            juce::gl::glUniformBlockBinding(shader->getProgramID(), block, binding);
+        }
     }
 
     return true;
+}
+
+// Points each sampler at the texture slot of its position in `samplers`. Programs are shared
+// between contexts, so samplers are set once here and everything else goes through uniform blocks.
+static void bindSamplers(GLProgram const &shader, std::initializer_list<char const *> samplers) {
+    shader.use();
+
+    GLint slot{ 0 };
+    for (auto *name : samplers) {
+        GLProgram::Uniform sampler{ shader, name };
+        if (sampler.uniformID >= 0) { sampler.set(slot); }
+        slot++;
+    }
 }
\ No newline at end of file